@@ -0,0 +1,172 @@
+/*
+ * dlog_bench.c
+ * Host benchmark for the deferred logger in dlog.c.
+ *
+ * Built with DLOG_NO_RTOS against the lab 4 message table. Checks that
+ * DLOG_format() prints what printf() would have for the lab's messages and
+ * that a full ring drops and counts records instead of overwriting them,
+ * then times the call-site cost of DLOG() against snprintf() of the same
+ * message, which is the formatting work xil_printf/printf used to do inline.
+ *
+ * Exits non-zero if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "dlog.h"
+
+#define WRITE_ITERATIONS 10000000
+
+static unsigned failures;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void drain(void) {
+    DlogRecord rec;
+
+    while (DLOG_read(&rec)) {
+    }
+}
+
+static void check_line(const char *what, const char *expected) {
+    char line[DLOG_LINE_LEN];
+    DlogRecord rec;
+
+    if (!DLOG_read(&rec)) {
+        printf("  FAIL %s: no record\n", what);
+        ++failures;
+        return;
+    }
+
+    DLOG_format(line, sizeof(line), &rec);
+    if (strcmp(line, expected) != 0) {
+        printf("  FAIL %s\n    got      \"%s\"\n    expected \"%s\"\n", what,
+               line, expected);
+        ++failures;
+    }
+}
+
+static void check_format(void) {
+    char expected[DLOG_LINE_LEN];
+    float speed = 512.34f, accel = -3.06f;
+    long position = -2048;
+
+    DLOG(LOG_POSITION, position);
+    snprintf(expected, sizeof(expected),
+             "Current position of the motor = %ld steps\n", position);
+    check_line("negative %d", expected);
+
+    DLOG(LOG_SPEED, DLOG_TENTHS(speed));
+    snprintf(expected, sizeof(expected),
+             "Current maximum speed of the motor = %0.1f steps/sec\n", speed);
+    check_line("%D", expected);
+
+    DLOG(LOG_ACCEL, DLOG_TENTHS(accel));
+    snprintf(expected, sizeof(expected),
+             "Current maximum acceleration of the motor = %0.1f "
+             "steps/sec/sec\n",
+             accel);
+    check_line("negative %D", expected);
+
+    DLOG(LOG_PAIR, 3, 4096, 3000);
+    snprintf(expected, sizeof(expected),
+             "*** Pair: %d\t, <destination, delay> = <%d, %d>\n\n", 3, 4096,
+             3000);
+    check_line("three arguments", expected);
+
+    DLOG(LOG_PAIR, 3);
+    check_line("missing arguments",
+               "*** Pair: 3\t, <destination, delay> = <?, ?>\n\n");
+
+    DLOG(LOG_MENU_HEADER);
+    check_line("no arguments",
+               "\n****************************** MENU "
+               "******************************\n");
+
+    printf("  formatting    %s\n", failures ? "FAILED" : "ok");
+}
+
+static void check_full_ring(void) {
+    u32 dropped = DLOG_dropped();
+    DlogRecord rec;
+    u32 i, read = 0, first = 0;
+
+    drain();
+    for (i = 0; i < DLOG_RING_LEN + 10; i++) {
+        DLOG(LOG_SLOTS, i);
+    }
+    while (DLOG_read(&rec)) {
+        if (read == 0) first = rec.args[0];
+        ++read;
+    }
+
+    if (read != DLOG_RING_LEN || first != 0 ||
+        DLOG_dropped() - dropped != 10) {
+        printf("  FAIL full ring: read %u, first %u, dropped %u\n", read,
+               first, DLOG_dropped() - dropped);
+        ++failures;
+    } else {
+        printf("  full ring     ok (%u kept, 10 dropped)\n", DLOG_RING_LEN);
+    }
+}
+
+static void bench_write(void) {
+    char line[DLOG_LINE_LEN];
+    volatile int sink = 0;
+    double t0, t_log, t_fmt;
+    DlogRecord rec;
+    u32 i;
+
+    drain();
+    t0 = now_s();
+    for (i = 0; i < WRITE_ITERATIONS; i++) {
+        DLOG(LOG_PAIR, i, 4096, 3000);
+        // Keep the ring from filling, the drain task's share is timed below
+        if ((i & (DLOG_RING_LEN - 1U)) == DLOG_RING_LEN - 1U) drain();
+    }
+    t_log = now_s() - t0;
+
+    t0 = now_s();
+    for (i = 0; i < WRITE_ITERATIONS; i++) {
+        sink += snprintf(line, sizeof(line),
+                         "*** Pair: %d\t, <destination, delay> = <%d, %d>\n\n",
+                         (int)i, 4096, 3000);
+    }
+    t_fmt = now_s() - t0;
+
+    printf("  DLOG()        %6.1f ns/record (ring + drain)\n",
+           t_log * 1e9 / WRITE_ITERATIONS);
+    printf("  snprintf()    %6.1f ns/message\n", t_fmt * 1e9 / WRITE_ITERATIONS);
+
+    DLOG(LOG_SPEED, DLOG_TENTHS(512.5f));
+    t0 = now_s();
+    for (i = 0; i < WRITE_ITERATIONS / 10; i++) {
+        DLOG_read(&rec);
+        sink += DLOG_format(line, sizeof(line), &rec);
+        // Put the record back so every pass formats it
+        DLOG(LOG_SPEED, DLOG_TENTHS(512.5f));
+    }
+    t_fmt = now_s() - t0;
+    printf("  DLOG_format() %6.1f ns/message (drain task side)\n",
+           t_fmt * 1e9 / (WRITE_ITERATIONS / 10));
+    (void)sink;
+}
+
+int main(void) {
+    printf("correctness\n");
+    check_format();
+    check_full_ring();
+
+    printf("\ncall-site cost (%u records)\n", WRITE_ITERATIONS);
+    bench_write();
+
+    printf("\n%s (%u failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
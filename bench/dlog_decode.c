@@ -0,0 +1,150 @@
+/*
+ * dlog_decode.c
+ * Host decoder for the deferred log records written by dlog.c.
+ *
+ * Built once per lab against that lab's dlog_formats.h, see CMakeLists.txt,
+ * and formats through the same DLOG_format() the drain task uses, so the
+ * output matches what the board would have printed.
+ *
+ * Input is either the UART capture of a DLOG_BINARY build, or a dump of
+ * DLOG_ring taken from the debugger, e.g. in xsct:
+ *   mrd -bin -file ring.bin DLOG_ring 1024
+ * Records are found by their magic byte, so text mixed into a capture is
+ * skipped. With -r the records are put back in sequence order, which a ring
+ * dump needs since the writers wrap around it.
+ *
+ * Usage: dlog_decode_<lab> [-r] [-c counts_per_second] file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlog.h"
+#include "xtime_l.h"
+
+#define RECORD_SIZE 32
+
+_Static_assert(sizeof(DlogRecord) == RECORD_SIZE, "DlogRecord layout");
+
+static u32 le32(const u8 *p) {
+    return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+// Parses the record at p, returns 0 if it cannot be one
+static int parse_record(const u8 *p, DlogRecord *rec) {
+    int i;
+
+    rec->seq       = le32(p);
+    rec->timestamp = le32(p + 4);
+    rec->id        = (u16)(p[8] | (p[9] << 8));
+    rec->argc      = p[10];
+    rec->magic     = p[11];
+    for (i = 0; i < DLOG_MAX_ARGS; i++) {
+        rec->args[i] = le32(p + 12 + 4 * i);
+    }
+
+    return rec->magic == DLOG_MAGIC && rec->id < DLOG_FORMAT_COUNT &&
+           rec->argc <= DLOG_MAX_ARGS;
+}
+
+static int by_seq(const void *a, const void *b) {
+    const DlogRecord *ra = a, *rb = b;
+
+    // Wrapping difference, so a sequence that rolled over still sorts
+    return ((s32)(ra->seq - rb->seq) > 0) - ((s32)(ra->seq - rb->seq) < 0);
+}
+
+static u8 *read_file(const char *path, size_t *len) {
+    FILE *f;
+    u8 *data = NULL;
+    size_t cap = 0, n;
+
+    f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+
+    *len = 0;
+    do {
+        if (*len == cap) {
+            cap  = cap ? cap * 2 : 65536;
+            data = realloc(data, cap);
+            if (data == NULL) break;
+        }
+        n = fread(data + *len, 1, cap - *len, f);
+        *len += n;
+    } while (n > 0);
+
+    fclose(f);
+    return data;
+}
+
+int main(int argc, char **argv) {
+    const char *path   = NULL;
+    double counts      = (double)COUNTS_PER_SECOND;
+    int ring_dump      = 0;
+    DlogRecord *recs   = NULL;
+    size_t count       = 0;
+    size_t len, off, i;
+    char line[DLOG_LINE_LEN];
+    u64 elapsed = 0;
+    u32 expected;
+    u8 *data;
+    int a;
+
+    for (a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-r") == 0) {
+            ring_dump = 1;
+        } else if (strcmp(argv[a], "-c") == 0 && a + 1 < argc) {
+            counts = strtod(argv[++a], NULL);
+        } else {
+            path = argv[a];
+        }
+    }
+    if (path == NULL || counts <= 0) {
+        fprintf(stderr, "usage: %s [-r] [-c counts_per_second] file\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    data = read_file(path, &len);
+    if (data == NULL) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+
+    recs = malloc((len / RECORD_SIZE + 1) * sizeof(*recs));
+    if (recs == NULL) return EXIT_FAILURE;
+
+    for (off = 0; off + RECORD_SIZE <= len;) {
+        if (parse_record(data + off, &recs[count]) &&
+            !(ring_dump && recs[count].seq == 0)) {
+            count++;
+            off += RECORD_SIZE;
+        } else {
+            off++;
+        }
+    }
+
+    if (ring_dump) qsort(recs, count, sizeof(*recs), by_seq);
+
+    for (i = 0; i < count; i++) {
+        // Records 0 apart from the drop reports come out of the ring
+        if (i > 0) {
+            elapsed += recs[i].timestamp - recs[i - 1].timestamp;
+            expected = recs[i - 1].seq + 1;
+            if (recs[i].seq != 0 && recs[i - 1].seq != 0 &&
+                recs[i].seq != expected) {
+                printf("-- %u records missing --\n", recs[i].seq - expected);
+            }
+        }
+
+        DLOG_format(line, sizeof(line), &recs[i]);
+        printf("[%12.6f] %s", elapsed / counts, line);
+        if (line[0] == '\0' || line[strlen(line) - 1] != '\n') putchar('\n');
+    }
+
+    fprintf(stderr, "%zu records\n", count);
+    free(recs);
+    free(data);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/*
+ * frame_bench.c
+ * Host benchmark for the lab2 frame codec in uart_frame.c.
+ *
+ * Checks the CRC against the CRC-16/CCITT-FALSE check value, COBS against
+ * known encodings and round trips, and that damaged frames are rejected.
+ * Then times packing and unpacking and works out the command rate the link
+ * allows for each command at the supported baud rates, pipelined frames
+ * against the text menu's one command per prompt cycle.
+ *
+ * The rate on the board comes from frame_client's "bench" command.
+ *
+ * Exits non-zero if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "uart_frame.h"
+
+#define CODEC_ITERATIONS 1000000
+
+static unsigned failures;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        printf("  FAIL %s\n", what);
+        ++failures;
+    }
+}
+
+typedef struct {
+    const char *name;
+    u8 raw[8];
+    size_t raw_len;
+    u8 encoded[8];
+    size_t encoded_len;
+} cobs_case_t;
+
+static const cobs_case_t cobs_cases[] = {
+    {"one zero", {0x00}, 1, {0x01, 0x01}, 2},
+    {"two zeros", {0x00, 0x00}, 2, {0x01, 0x01, 0x01}, 3},
+    {"zero inside", {0x11, 0x22, 0x00, 0x33}, 4, {0x03, 0x11, 0x22, 0x02, 0x33},
+     5},
+    {"no zero", {0x11, 0x22, 0x33, 0x44}, 4, {0x05, 0x11, 0x22, 0x33, 0x44}, 5},
+    {"trailing zero", {0x11, 0x00}, 2, {0x02, 0x11, 0x01}, 3},
+};
+
+static void check_codec(void) {
+    u8 wire[FRAME_MAX_WIRE], decoded[FRAME_MAX_WIRE], raw[FRAME_MAX_RAW];
+    FramePacket pkt;
+    size_t i, n, len;
+    unsigned before = failures;
+
+    check(FRAME_crc16((const u8 *)"123456789", 9) == 0x29B1, "CRC check value");
+
+    for (i = 0; i < sizeof(cobs_cases) / sizeof(cobs_cases[0]); i++) {
+        n = FRAME_cobsEncode(cobs_cases[i].raw, cobs_cases[i].raw_len, wire);
+        check(n == cobs_cases[i].encoded_len &&
+                  memcmp(wire, cobs_cases[i].encoded, n) == 0,
+              cobs_cases[i].name);
+        n = FRAME_cobsDecode(wire, n, decoded);
+        check(n == cobs_cases[i].raw_len &&
+                  memcmp(decoded, cobs_cases[i].raw, n) == 0,
+              cobs_cases[i].name);
+    }
+
+    // Runs of non-zero bytes across the 254-byte block limit
+    for (len = 250; len <= FRAME_MAX_RAW; len += 1) {
+        for (i = 0; i < len; i++) {
+            raw[i] = (u8)((i % 255) + 1);
+        }
+        if (len % 100 == 0) raw[len / 2] = 0;
+        n = FRAME_cobsEncode(raw, len, wire);
+        check(memchr(wire, 0, n) == NULL && n <= FRAME_MAX_WIRE - 1,
+              "no delimiter in encoding");
+        n = FRAME_cobsDecode(wire, n, decoded);
+        check(n == len && memcmp(decoded, raw, len) == 0, "long round trip");
+    }
+
+    // Full packets, every payload length
+    for (len = 0; len <= FRAME_MAX_PAYLOAD; len++) {
+        for (i = 0; i < len; i++) {
+            raw[i] = (u8)(i * 7);
+        }
+        n = FRAME_pack(wire, FRAME_CMD_HASH, 0, (u16)(0xAB00 + len), raw,
+                       (u16)len);
+        check(n > 0 && wire[n - 1] == FRAME_DELIMITER &&
+                  memchr(wire, 0, n - 1) == NULL,
+              "packed frame delimiting");
+        n = FRAME_cobsDecode(wire, n - 1, decoded);
+        check(FRAME_unpack(decoded, n, &pkt) == XST_SUCCESS &&
+                  pkt.cmd == FRAME_CMD_HASH && pkt.id == 0xAB00 + len &&
+                  pkt.len == len && memcmp(pkt.payload, raw, len) == 0,
+              "packet round trip");
+
+        // Any single flipped bit must be caught
+        decoded[len % n] ^= (u8)(1 << (len % 8));
+        check(FRAME_unpack(decoded, n, &pkt) != XST_SUCCESS,
+              "corrupt packet rejected");
+    }
+
+    check(FRAME_pack(wire, FRAME_CMD_PING, 0, 1, raw, FRAME_MAX_PAYLOAD + 1) ==
+              0,
+          "oversized payload refused");
+
+    printf("  codec         %s\n", failures == before ? "ok" : "FAILED");
+}
+
+static void bench_codec(void) {
+    u8 wire[FRAME_MAX_WIRE], decoded[FRAME_MAX_WIRE], payload[64];
+    volatile size_t sink = 0;
+    FramePacket pkt;
+    double t0, elapsed;
+    size_t n;
+    u32 i;
+
+    memset(payload, 'a', sizeof(payload));
+
+    t0 = now_s();
+    for (i = 0; i < CODEC_ITERATIONS; i++) {
+        n = FRAME_pack(wire, FRAME_CMD_HASH, 0, (u16)i, payload,
+                       sizeof(payload));
+        n = FRAME_cobsDecode(wire, n - 1, decoded);
+        sink += FRAME_unpack(decoded, n, &pkt);
+    }
+    elapsed = now_s() - t0;
+    (void)sink;
+
+    printf("  pack + unpack %7.1f ns/frame (64 byte payload)\n",
+           elapsed * 1e9 / CODEC_ITERATIONS);
+}
+
+// Bytes on the wire for one frame
+static size_t frame_bytes(u16 payload_len) {
+    u8 wire[FRAME_MAX_WIRE], payload[FRAME_MAX_PAYLOAD] = {0};
+
+    return FRAME_pack(wire, FRAME_CMD_PING, 0, 0x1234, payload, payload_len);
+}
+
+static void bench_link(void) {
+    static const struct {
+        const char *name;
+        u16 request_len, response_len;
+    } cmds[] = {
+        {"led", 2, 0},
+        {"ssd", 2, 0},
+        {"hash 16 B", 16, 32},
+        {"hash 512 B", 512, 32},
+    };
+    static const u32 bauds[] = {115200, 921600};
+    size_t i, j, bytes;
+
+    // 10 bits per byte. Requests and responses travel in opposite
+    // directions at the same time, so the busier one sets the rate.
+    printf("  %-12s", "command");
+    for (j = 0; j < 2; j++) {
+        printf(" %9lu baud", (unsigned long)bauds[j]);
+    }
+    printf("\n");
+    for (i = 0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
+        printf("  %-12s", cmds[i].name);
+        for (j = 0; j < 2; j++) {
+            bytes = frame_bytes(cmds[i].request_len);
+            if (frame_bytes(cmds[i].response_len) > bytes) {
+                bytes = frame_bytes(cmds[i].response_len);
+            }
+            printf(" %9.0f cmd/s", bauds[j] / 10.0 / bytes);
+        }
+        printf("\n");
+    }
+    printf("  text menu: one command per ~2 s (1 s delay, any key, 1 s)\n");
+}
+
+int main(void) {
+    printf("correctness\n");
+    check_codec();
+
+    printf("\ncodec cost\n");
+    bench_codec();
+
+    printf("\nlink-limited command rate, pipelined\n");
+    bench_link();
+
+    printf("\n%s (%u failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,410 @@
+/*
+ * frame_client.c
+ * Host client for the lab2 binary command protocol in uart_frame.h.
+ *
+ * Talks to the board over the USB serial port. The CLI has to be sitting at
+ * its menu prompt, the client's first 0x00 switches it to binary mode and
+ * "text" switches it back.
+ *
+ * "bench" streams commands back to back, keeping as many in flight as fit
+ * in FRAME_RX_WINDOW bytes, matches the responses by ID and reports
+ * commands per second and the round-trip latency.
+ *
+ * Usage: frame_client <tty> [-b baud] <command> [args]
+ *   ping [text]                 echo
+ *   led <brightness> <color>    lab2/part2, color 0-7 as in rgb_led.h
+ *   ssd <two chars>             lab2/part2
+ *   baud <rate>                 lab2/part2, the client follows the switch
+ *   hash <text>                 lab2/part1
+ *   verify <hex hash> <text>    lab2/part1
+ *   text                        back to the menu
+ *   bench <ping|led|ssd|hash> <count> [payload bytes]
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "uart_frame.h"
+
+#define RESPONSE_TIMEOUT_S 2.0
+#define MAX_IN_FLIGHT      256
+
+typedef struct {
+    int fd;
+    u16 next_id;
+    u8 rx[FRAME_MAX_WIRE];
+    size_t rx_len;
+    u8 rx_overflow;
+    u32 corrupt; // Frames from the board that failed to decode
+} link_t;
+
+typedef struct {
+    u16 id;
+    u16 wire_len;
+    double sent_at;
+} in_flight_t;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// -------------------------------------------------
+// Serial port
+// -------------------------------------------------
+static speed_t baud_constant(long baud) {
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return 0;
+    }
+}
+
+static int set_baud(int fd, long baud) {
+    struct termios tio;
+    speed_t speed = baud_constant(baud);
+
+    if (speed == 0 || tcgetattr(fd, &tio) != 0) return -1;
+
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_iflag &= ~(IXON | IXOFF | IXANY);
+    tio.c_cc[VMIN]  = 0;
+    tio.c_cc[VTIME] = 1; // Reads return after 100 ms of silence
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+static int write_all(int fd, const u8 *buf, size_t len) {
+    ssize_t n;
+
+    while (len > 0) {
+        n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// -------------------------------------------------
+// Frames
+// -------------------------------------------------
+static int send_frame(link_t *link, u8 cmd, u16 id, const void *payload,
+                      u16 len, u16 *wire_len) {
+    u8 wire[FRAME_MAX_WIRE];
+    size_t n;
+
+    n = FRAME_pack(wire, cmd, 0, id, payload, len);
+    if (n == 0) return -1;
+    if (wire_len) *wire_len = (u16)n;
+
+    return write_all(link->fd, wire, n);
+}
+
+// Returns 1 with a response in pkt, 0 on timeout, -1 on a read error
+static int read_frame(link_t *link, FramePacket *pkt, double timeout_s) {
+    static u8 pending[256]; // Read from the port, not yet looked at
+    static size_t pending_len, pending_pos;
+    u8 decoded[FRAME_MAX_WIRE];
+    double deadline = now_s() + timeout_s;
+    size_t len;
+    ssize_t n;
+    u8 b;
+
+    for (;;) {
+        if (pending_pos == pending_len) {
+            if (now_s() > deadline) return 0;
+            n = read(link->fd, pending, sizeof(pending));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            pending_len = (size_t)n;
+            pending_pos = 0;
+            continue;
+        }
+
+        b = pending[pending_pos++];
+        if (b != FRAME_DELIMITER) {
+            if (link->rx_len < sizeof(link->rx)) {
+                link->rx[link->rx_len++] = b;
+            } else {
+                link->rx_overflow = 1;
+            }
+            continue;
+        }
+
+        len          = link->rx_len;
+        link->rx_len = 0;
+        if (len == 0) continue;
+        if (link->rx_overflow) {
+            link->rx_overflow = 0;
+            ++link->corrupt;
+            continue;
+        }
+
+        len = FRAME_cobsDecode(link->rx, len, decoded);
+        if (FRAME_unpack(decoded, len, pkt) != XST_SUCCESS) {
+            // Menu text from before the switch ends up here too
+            ++link->corrupt;
+            continue;
+        }
+
+        return 1;
+    }
+}
+
+static int request(link_t *link, u8 cmd, const void *payload, u16 len,
+                   FramePacket *rsp) {
+    u16 id = link->next_id++;
+    int r;
+
+    if (send_frame(link, cmd, id, payload, len, NULL) != 0) return -1;
+
+    for (;;) {
+        r = read_frame(link, rsp, RESPONSE_TIMEOUT_S);
+        if (r <= 0) {
+            fprintf(stderr, "no response to id %u\n", id);
+            return -1;
+        }
+        if (rsp->id == id && rsp->cmd == (cmd | FRAME_RESPONSE)) break;
+        if (rsp->status == FRAME_ERR_CORRUPT) {
+            fprintf(stderr, "board reported a corrupt frame\n");
+            return -1;
+        }
+    }
+
+    if (rsp->status != FRAME_OK) {
+        fprintf(stderr, "status %u\n", rsp->status);
+        return -1;
+    }
+    return 0;
+}
+
+// -------------------------------------------------
+// Commands
+// -------------------------------------------------
+static void print_hex(const u8 *buf, size_t len) {
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        printf("%02X", buf[i]);
+    }
+    printf("\n");
+}
+
+static int parse_hex(const char *hex, u8 *out, size_t len) {
+    size_t i;
+    unsigned v;
+
+    if (strlen(hex) != 2 * len) return -1;
+    for (i = 0; i < len; i++) {
+        if (sscanf(&hex[2 * i], "%2x", &v) != 1) return -1;
+        out[i] = (u8)v;
+    }
+    return 0;
+}
+
+static int run_bench(link_t *link, const char *what, long count,
+                     long payload_len) {
+    static in_flight_t in_flight[MAX_IN_FLIGHT];
+    u8 payload[FRAME_MAX_PAYLOAD];
+    size_t n_in_flight = 0, window_bytes = 0, max_in_flight = 0, i;
+    long sent = 0, done = 0;
+    double t0, latency = 0, latency_max = 0, elapsed, rtt;
+    u16 len, wire_len;
+    FramePacket rsp;
+    u8 cmd;
+    int r;
+
+    if (strcmp(what, "ping") == 0) {
+        cmd = FRAME_CMD_PING;
+        len = (u16)payload_len;
+    } else if (strcmp(what, "hash") == 0) {
+        cmd = FRAME_CMD_HASH;
+        len = (u16)payload_len;
+    } else if (strcmp(what, "led") == 0) {
+        cmd = FRAME_CMD_LED;
+        len = 2;
+    } else if (strcmp(what, "ssd") == 0) {
+        cmd = FRAME_CMD_SSD;
+        len = 2;
+    } else {
+        fprintf(stderr, "unknown bench command %s\n", what);
+        return -1;
+    }
+    if (payload_len < 0 || payload_len > FRAME_MAX_PAYLOAD) return -1;
+
+    for (i = 0; i < sizeof(payload); i++) {
+        payload[i] = (u8)('a' + i % 26);
+    }
+
+    t0 = now_s();
+    while (done < count) {
+        // Fill the window, one frame is always allowed
+        while (sent < count && n_in_flight < MAX_IN_FLIGHT) {
+            if (cmd == FRAME_CMD_LED) {
+                payload[0] = (u8)sent;
+                payload[1] = (u8)(sent % 8);
+            } else if (cmd == FRAME_CMD_SSD) {
+                payload[0] = "0123456789ABCDEF"[sent % 16];
+                payload[1] = "0123456789ABCDEF"[(sent + 1) % 16];
+            }
+
+            wire_len = (u16)(len + FRAME_HEADER_LEN + FRAME_CRC_LEN + 4);
+            if (n_in_flight > 0 && window_bytes + wire_len > FRAME_RX_WINDOW) {
+                break;
+            }
+
+            in_flight[n_in_flight].id      = link->next_id;
+            in_flight[n_in_flight].sent_at = now_s();
+            if (send_frame(link, cmd, link->next_id++, payload, len,
+                           &wire_len) != 0) {
+                return -1;
+            }
+            in_flight[n_in_flight].wire_len = wire_len;
+            window_bytes += wire_len;
+            ++n_in_flight;
+            ++sent;
+        }
+        if (n_in_flight > max_in_flight) max_in_flight = n_in_flight;
+
+        r = read_frame(link, &rsp, RESPONSE_TIMEOUT_S);
+        if (r <= 0) {
+            fprintf(stderr, "stalled after %ld responses\n", done);
+            return -1;
+        }
+        if (rsp.status != FRAME_OK) {
+            fprintf(stderr, "id %u status %u\n", rsp.id, rsp.status);
+            return -1;
+        }
+
+        for (i = 0; i < n_in_flight && in_flight[i].id != rsp.id; i++) {
+        }
+        if (i == n_in_flight) continue; // Late answer from an earlier run
+
+        rtt = now_s() - in_flight[i].sent_at;
+        latency += rtt;
+        if (rtt > latency_max) latency_max = rtt;
+        window_bytes -= in_flight[i].wire_len;
+        in_flight[i] = in_flight[--n_in_flight];
+        ++done;
+    }
+    elapsed = now_s() - t0;
+
+    printf("%s x %ld, %u byte payload\n", what, count, len);
+    printf("  %10.1f commands/s\n", count / elapsed);
+    printf("  %10.1f KB/s of payload\n", count * len / elapsed / 1024);
+    printf("  %10.2f ms mean round trip, %.2f ms worst\n",
+           latency * 1e3 / count, latency_max * 1e3);
+    printf("  %10zu commands in flight at most\n", max_in_flight);
+    if (link->corrupt) printf("  %10u corrupt frames\n", link->corrupt);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static const u8 enter = FRAME_DELIMITER;
+    link_t link = {0};
+    FramePacket rsp;
+    long baud = 115200;
+    u8 payload[FRAME_MAX_PAYLOAD];
+    size_t len;
+    int a   = 2;
+    int r   = -1;
+    u32 new_baud;
+
+    if (argc > 3 && strcmp(argv[2], "-b") == 0) {
+        baud = strtol(argv[3], NULL, 10);
+        a    = 4;
+    }
+    if (argc <= a) {
+        fprintf(stderr,
+                "usage: %s <tty> [-b baud] ping|led|ssd|baud|hash|verify|"
+                "text|bench [args]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    link.fd = open(argv[1], O_RDWR | O_NOCTTY);
+    if (link.fd < 0) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+    if (set_baud(link.fd, baud) != 0) {
+        fprintf(stderr, "cannot set %ld baud\n", baud);
+        return EXIT_FAILURE;
+    }
+
+    // Switches the menu to binary mode, an extra delimiter is harmless
+    tcflush(link.fd, TCIOFLUSH);
+    write_all(link.fd, &enter, 1);
+    link.next_id = (u16)getpid();
+
+    if (strcmp(argv[a], "ping") == 0) {
+        len = (argc > a + 1) ? strlen(argv[a + 1]) : 0;
+        if (len > FRAME_MAX_PAYLOAD) len = FRAME_MAX_PAYLOAD;
+        r = request(&link, FRAME_CMD_PING, argv[a + 1], (u16)len, &rsp);
+        if (r == 0) printf("%.*s\n", rsp.len, (const char *)rsp.payload);
+    } else if (strcmp(argv[a], "led") == 0 && argc > a + 2) {
+        payload[0] = (u8)atoi(argv[a + 1]);
+        payload[1] = (u8)atoi(argv[a + 2]);
+        r          = request(&link, FRAME_CMD_LED, payload, 2, &rsp);
+    } else if (strcmp(argv[a], "ssd") == 0 && argc > a + 1 &&
+               strlen(argv[a + 1]) == 2) {
+        r = request(&link, FRAME_CMD_SSD, argv[a + 1], 2, &rsp);
+    } else if (strcmp(argv[a], "baud") == 0 && argc > a + 1) {
+        new_baud   = (u32)strtoul(argv[a + 1], NULL, 10);
+        payload[0] = (u8)new_baud;
+        payload[1] = (u8)(new_baud >> 8);
+        payload[2] = (u8)(new_baud >> 16);
+        payload[3] = (u8)(new_baud >> 24);
+        r          = request(&link, FRAME_CMD_BAUD, payload, 4, &rsp);
+        if (r == 0) r = set_baud(link.fd, (long)new_baud);
+    } else if (strcmp(argv[a], "hash") == 0 && argc > a + 1) {
+        len = strlen(argv[a + 1]);
+        if (len > FRAME_MAX_PAYLOAD) len = FRAME_MAX_PAYLOAD;
+        r = request(&link, FRAME_CMD_HASH, argv[a + 1], (u16)len, &rsp);
+        if (r == 0) print_hex(rsp.payload, rsp.len);
+    } else if (strcmp(argv[a], "verify") == 0 && argc > a + 2) {
+        len = strlen(argv[a + 2]);
+        if (len > FRAME_MAX_PAYLOAD - 32) len = FRAME_MAX_PAYLOAD - 32;
+        if (parse_hex(argv[a + 1], payload, 32) != 0) {
+            fprintf(stderr, "expected 64 hex digits\n");
+        } else {
+            memcpy(&payload[32], argv[a + 2], len);
+            r = request(&link, FRAME_CMD_VERIFY, payload, (u16)(32 + len),
+                        &rsp);
+            if (r == 0) printf("%s\n", rsp.payload[0] ? "match" : "different");
+        }
+    } else if (strcmp(argv[a], "text") == 0) {
+        r = request(&link, FRAME_CMD_TEXT, NULL, 0, &rsp);
+    } else if (strcmp(argv[a], "bench") == 0 && argc > a + 2) {
+        r = run_bench(&link, argv[a + 1], strtol(argv[a + 2], NULL, 10),
+                      (argc > a + 3) ? strtol(argv[a + 3], NULL, 10) : 0);
+    } else {
+        fprintf(stderr, "bad command\n");
+    }
+
+    close(link.fd);
+    return (r == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
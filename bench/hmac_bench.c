@@ -0,0 +1,186 @@
+/*
+ * hmac_bench.c
+ * Host benchmark for the lab2/part1 HMAC-SHA256 in hmac_sha256.c.
+ *
+ * Checks the RFC 4231 test cases 1-7, case 5 truncated to 128 bits as the
+ * RFC gives it, and that split updates give the same MAC. Then compares
+ * MACs per second with the cached key states against setting the key up
+ * for every MAC, which is what a plain HMAC over sha256.h costs, for short
+ * messages where the two key blocks dominate.
+ *
+ * Exits non-zero if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hmac_sha256.h"
+
+#define BENCH_MACS   (1u << 18) // Per trial
+#define BENCH_TRIALS 5          // Best trial counts, the host is shared
+
+static unsigned failures;
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        printf("  FAIL %s\n", what);
+        ++failures;
+    }
+}
+
+static size_t from_hex(const char *hex, BYTE *out) {
+    size_t n = 0;
+    unsigned byte;
+
+    while (hex[0] && hex[1] && sscanf(hex, "%2x", &byte) == 1) {
+        out[n++] = (BYTE)byte;
+        hex += 2;
+    }
+    return n;
+}
+
+typedef struct {
+    BYTE key_byte; // Repeated key_len times, 0 for the counting key of case 4
+    size_t key_len;
+    const char *key_text; // Used instead when set
+    BYTE data_byte;       // Repeated data_len times when data_text is NULL
+    size_t data_len;
+    const char *data_text;
+    const char *mac_hex; // 16 bytes for case 5
+} rfc4231_case_t;
+
+static const rfc4231_case_t cases[] = {
+    {0x0b, 20, NULL, 0, 0, "Hi There",
+     "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"},
+    {0, 0, "Jefe", 0, 0, "what do ya want for nothing?",
+     "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"},
+    {0xaa, 20, NULL, 0xdd, 50, NULL,
+     "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe"},
+    {0, 25, NULL, 0xcd, 50, NULL,
+     "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b"},
+    {0x0c, 20, NULL, 0, 0, "Test With Truncation",
+     "a3b6167473100ee06e0c796c2955552b"},
+    {0xaa, 131, NULL, 0, 0,
+     "Test Using Larger Than Block-Size Key - Hash Key First",
+     "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"},
+    {0xaa, 131, NULL, 0, 0,
+     "This is a test using a larger than block-size key and a larger than "
+     "block-size data. The key needs to be hashed before being used by the "
+     "HMAC algorithm.",
+     "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2"},
+};
+
+static void check_rfc4231(void) {
+    BYTE key_buf[131], data_buf[64], want[HMAC_SHA256_LEN];
+    BYTE mac[HMAC_SHA256_LEN], split[HMAC_SHA256_LEN];
+    const BYTE *key, *data;
+    size_t key_len, data_len, want_len, i, j;
+    HMAC_SHA256_KEY hkey;
+    HMAC_SHA256_CTX ctx;
+    unsigned before = failures;
+    char what[64];
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        if (cases[i].key_text != NULL) {
+            key     = (const BYTE *)cases[i].key_text;
+            key_len = strlen(cases[i].key_text);
+        } else {
+            for (j = 0; j < cases[i].key_len; j++) {
+                key_buf[j] = cases[i].key_byte ? cases[i].key_byte
+                                               : (BYTE)(j + 1);
+            }
+            key     = key_buf;
+            key_len = cases[i].key_len;
+        }
+
+        if (cases[i].data_text != NULL) {
+            data     = (const BYTE *)cases[i].data_text;
+            data_len = strlen(cases[i].data_text);
+        } else {
+            memset(data_buf, cases[i].data_byte, cases[i].data_len);
+            data     = data_buf;
+            data_len = cases[i].data_len;
+        }
+
+        want_len = from_hex(cases[i].mac_hex, want);
+
+        hmacSha256SetKey(&hkey, key, key_len);
+        hmacSha256(&hkey, data, data_len, mac);
+        snprintf(what, sizeof(what), "RFC 4231 case %zu", i + 1);
+        check(memcmp(mac, want, want_len) == 0, what);
+
+        // One byte at a time through the streaming calls
+        hmacSha256Init(&ctx, &hkey);
+        for (j = 0; j < data_len; j++) {
+            hmacSha256Update(&ctx, &data[j], 1);
+        }
+        hmacSha256Final(&ctx, split);
+        snprintf(what, sizeof(what), "RFC 4231 case %zu, split", i + 1);
+        check(memcmp(split, mac, sizeof(mac)) == 0, what);
+    }
+
+    printf("RFC 4231 vectors: %s\n", failures == before ? "ok" : "FAILED");
+}
+
+// MACs per second over len-byte messages, rekeying for every MAC or not
+static double rate_macs_s(int rekey, const BYTE *key, const BYTE *data,
+                          size_t len) {
+    HMAC_SHA256_KEY hkey;
+    BYTE mac[HMAC_SHA256_LEN];
+    volatile BYTE sink = 0;
+    double start, elapsed, best = 0;
+    size_t i;
+    int trial;
+
+    hmacSha256SetKey(&hkey, key, 32);
+
+    for (trial = 0; trial < BENCH_TRIALS; trial++) {
+        start = now_s();
+        for (i = 0; i < BENCH_MACS; i++) {
+            if (rekey) hmacSha256SetKey(&hkey, key, 32);
+            hmacSha256(&hkey, data, len, mac);
+            sink ^= mac[0];
+        }
+        elapsed = now_s() - start;
+        if (trial == 0 || elapsed < best) best = elapsed;
+    }
+    (void)sink;
+
+    return BENCH_MACS / best;
+}
+
+int main(void) {
+    static const size_t sizes[] = {16, 64, 256, 1024};
+    BYTE key[32], data[1024];
+    double rekeyed, cached;
+    size_t i;
+
+    check_rfc4231();
+
+    for (i = 0; i < sizeof(key); i++) {
+        key[i] = (BYTE)(i * 29 + 3);
+    }
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (BYTE)(i * 131 + 7);
+    }
+
+    printf("\n%10s %14s %14s %8s\n", "message", "rekeyed MAC/s",
+           "cached MAC/s", "speedup");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        rekeyed = rate_macs_s(1, key, data, sizes[i]);
+        cached  = rate_macs_s(0, key, data, sizes[i]);
+        printf("%10zu %14.0f %14.0f %7.2fx\n", sizes[i], rekeyed, cached,
+               cached / rekeyed);
+    }
+
+    printf("\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
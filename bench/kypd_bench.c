@@ -0,0 +1,300 @@
+/*
+ * kypd_bench.c
+ * Host benchmark for the PmodKYPD driver.
+ *
+ * The driver is built with KYPD_NO_RTOS and talks to the mocked GPIO in
+ * mock/mock_gpio.c, which simulates the 4x4 matrix (including ghosting) and
+ * counts every register access. Scripted key sequences are replayed through
+ * both scan modes to check the decoded keystates, the debounce and the event
+ * queue, then each stage is timed.
+ *
+ * Exits non-zero if any check fails. Multi-key results of the shift pattern
+ * scan are reported but not checked, that decoder cannot resolve chords.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "mock_gpio.h"
+#include "pmodkypd.h"
+
+#define DEFAULT_KEYTABLE "0FED789C456B123A"
+
+#define SCAN_ITERATIONS   2000000
+#define DECODE_ITERATIONS 64
+#define SAMPLE_ITERATIONS 4000000
+
+// Key at row r, column c, column n lands on bit (3 - n) of its row nibble
+#define KEY(r, c) (1 << (4 * (r) + (3 - (c))))
+
+typedef struct chord_case {
+    const char *name;
+    u16 pressed;  // Keys held on the matrix
+    u16 expected; // Keystate the scan must return, ghosts included
+    u32 status;   // Expected KYPD_getKeysPressed status
+} chord_case_t;
+
+static const chord_case_t chords[] = {
+    {"same row", KEY(0, 0) | KEY(0, 3), KEY(0, 0) | KEY(0, 3),
+     KYPD_MULTI_KEY},
+    {"same column", KEY(1, 2) | KEY(3, 2), KEY(1, 2) | KEY(3, 2),
+     KYPD_MULTI_KEY},
+    {"diagonal", KEY(0, 0) | KEY(1, 1) | KEY(2, 2) | KEY(3, 3),
+     KEY(0, 0) | KEY(1, 1) | KEY(2, 2) | KEY(3, 3), KYPD_MULTI_KEY},
+    {"L shape", KEY(0, 0) | KEY(0, 1) | KEY(1, 0),
+     KEY(0, 0) | KEY(0, 1) | KEY(1, 0) | KEY(1, 1), KYPD_GHOST_KEY},
+    {"rectangle", KEY(1, 1) | KEY(1, 3) | KEY(3, 1) | KEY(3, 3),
+     KEY(1, 1) | KEY(1, 3) | KEY(3, 1) | KEY(3, 3), KYPD_GHOST_KEY},
+    {"row + corner", KEY(2, 0) | KEY(2, 1) | KEY(2, 2) | KEY(3, 0),
+     KEY(2, 0) | KEY(2, 1) | KEY(2, 2) | KEY(3, 0) | KEY(3, 1) | KEY(3, 2),
+     KYPD_GHOST_KEY},
+    {"all keys", 0xFFFF, 0xFFFF, KYPD_GHOST_KEY},
+};
+
+// Raw samples for one key, taken every KYPD_POLL_PERIOD
+static const u8 bounce_press[] = {1, 0, 1, 1, 0, 1, 1, 1};
+static const u8 bounce_release[] = {0, 1, 0, 0, 1, 0, 0, 0};
+static const u8 glitches[] = {1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0};
+
+#define HOLD_SAMPLES 100 // 1 s held, long enough for the auto-repeat
+
+static const char *mode_names[] = {"column walk", "shift pattern"};
+
+static PmodKYPD KYPDInst;
+static u32 failures = 0;
+static volatile u32 sink;
+
+static double now_seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void check(int ok, const char *mode, const char *what) {
+    if (!ok) {
+        printf("  FAIL [%s] %s\n", mode, what);
+        failures++;
+    }
+}
+
+static void reset_keypad(u32 mode) {
+    KYPD_begin(&KYPDInst, MOCK_KYPD_BASEADDR);
+    KYPD_loadKeyTable(&KYPDInst, (u8 *)DEFAULT_KEYTABLE);
+    KYPD_setScanMode(&KYPDInst, mode);
+    mock_kypd_press(0);
+}
+
+// Every single key must decode to its own bit and label
+static u32 check_single_keys(u32 mode) {
+    u32 passed = 0;
+    u16 keystate;
+    u32 i, status;
+    u8 key = 0;
+
+    for (i = 0; i < 16; i++) {
+        mock_kypd_press(1 << i);
+        keystate = KYPD_getKeyStates(&KYPDInst);
+        status = KYPD_getKeyPressed(&KYPDInst, keystate, &key);
+        if (keystate == (1 << i) && status == KYPD_SINGLE_KEY &&
+            key == DEFAULT_KEYTABLE[i])
+            passed++;
+    }
+
+    mock_kypd_press(0);
+    if (KYPD_getKeyStates(&KYPDInst) == 0) passed++;
+
+    printf("  %-14s single keys   %2u/17\n", mode_names[mode], passed);
+    return passed == 17;
+}
+
+static u32 check_chords(u32 mode) {
+    u32 n = sizeof(chords) / sizeof(chords[0]);
+    u32 passed = 0;
+    u8 keys[16];
+    u16 keystate;
+    u32 i, count, status;
+
+    for (i = 0; i < n; i++) {
+        mock_kypd_press(chords[i].pressed);
+        keystate = KYPD_getKeyStates(&KYPDInst);
+        status = KYPD_getKeysPressed(&KYPDInst, keystate, keys, &count);
+        if (keystate == chords[i].expected && status == chords[i].status &&
+            count == KYPD_countKeys(chords[i].expected))
+            passed++;
+        else if (mode == KYPD_SCAN_COLUMN_WALK)
+            printf("    %-12s got 0x%04X, expected 0x%04X\n", chords[i].name,
+                   keystate, chords[i].expected);
+    }
+    mock_kypd_press(0);
+
+    printf("  %-14s chords        %2u/%u\n", mode_names[mode], passed, n);
+    return passed == n;
+}
+
+// Poll the keypad once per KYPD_POLL_PERIOD with each scripted sample
+static u32 replay(u16 key, const u8 *samples, u32 len, u32 *tick) {
+    u32 events = 0;
+    u32 i;
+
+    for (i = 0; i < len; i++) {
+        mock_kypd_press(samples[i] ? key : 0);
+        events += KYPD_pollEvents(&KYPDInst, *tick);
+        *tick += KYPD_POLL_PERIOD;
+    }
+    return events;
+}
+
+static u32 check_debounce(u32 mode) {
+    u32 index = 5;
+    u16 key = 1 << index;
+    u32 tick = 0, press_tick = 0, release_tick = 0, expect_repeats;
+    u32 presses = 0, releases = 0, repeats = 0, other = 0;
+    KYPD_Event event;
+    u8 hold = 1;
+    u32 ok = TRUE;
+    u32 i;
+
+    reset_keypad(mode);
+
+    // Isolated glitches never hold for KYPD_DEBOUNCE_SAMPLES
+    ok &= replay(key, glitches, sizeof(glitches), &tick) == 0;
+
+    replay(key, bounce_press, sizeof(bounce_press), &tick);
+    for (i = 0; i < HOLD_SAMPLES; i++) replay(key, &hold, 1, &tick);
+    replay(key, bounce_release, sizeof(bounce_release), &tick);
+
+    while (KYPD_readEvent(&KYPDInst, &event) == XST_SUCCESS) {
+        if (event.index != index || event.key != DEFAULT_KEYTABLE[index]) {
+            other++;
+        } else if (event.type == KYPD_EVENT_PRESS) {
+            presses++;
+            press_tick = event.tick;
+        } else if (event.type == KYPD_EVENT_RELEASE) {
+            releases++;
+            release_tick = event.tick;
+        } else {
+            repeats++;
+        }
+    }
+
+    // The release is detected on the sample after the last repeat could fire
+    expect_repeats = 0;
+    if (release_tick - press_tick > KYPD_REPEAT_DELAY)
+        expect_repeats = (release_tick - press_tick - KYPD_REPEAT_DELAY - 1) /
+                             KYPD_REPEAT_PERIOD + 1;
+
+    ok &= presses == 1 && releases == 1 && other == 0;
+    ok &= repeats == expect_repeats && KYPDInst.events_dropped == 0;
+    ok &= KYPD_getDebouncedKeyStates(&KYPDInst) == 0;
+
+    printf("  %-14s debounce      %s (press %u, repeat %u, release %u, "
+           "held %u ms)\n",
+           mode_names[mode], ok ? "ok" : "BAD", presses, repeats, releases,
+           release_tick - press_tick);
+    return ok;
+}
+
+static void bench_scan(u32 mode) {
+    u32 reads, writes, cost;
+    double start, elapsed;
+    u32 acc = 0;
+    u32 i;
+
+    reset_keypad(mode);
+    mock_kypd_press(KEY(2, 1));
+    mock_gpio_reset_counts();
+
+    start = now_seconds();
+    for (i = 0; i < SCAN_ITERATIONS; i++) acc += KYPD_getKeyStates(&KYPDInst);
+    elapsed = now_seconds() - start;
+
+    reads = mock_gpio_reads();
+    writes = mock_gpio_writes();
+    cost = KYPD_getScanCost(&KYPDInst);
+    sink = acc;
+
+    printf("  %-14s %10.0f scans/s %7.1f ns/scan  MMIO/scan %.1f "
+           "(%.1f rd, %.1f wr, driver reports %u)\n",
+           mode_names[mode], SCAN_ITERATIONS / elapsed,
+           elapsed * 1e9 / SCAN_ITERATIONS,
+           (double)(reads + writes) / SCAN_ITERATIONS,
+           (double)reads / SCAN_ITERATIONS, (double)writes / SCAN_ITERATIONS,
+           cost);
+    check(reads + writes == cost * SCAN_ITERATIONS, mode_names[mode],
+          "scan cost does not match the GPIO accesses");
+}
+
+static void bench_decode(void) {
+    u8 keys[16];
+    double start, elapsed;
+    u32 acc = 0, count;
+    u32 n, ks;
+
+    reset_keypad(KYPD_SCAN_COLUMN_WALK);
+    start = now_seconds();
+    for (n = 0; n < DECODE_ITERATIONS; n++) {
+        for (ks = 0; ks < 0x10000; ks++) {
+            acc += KYPD_getKeysPressed(&KYPDInst, ks, keys, &count);
+            acc += count;
+        }
+    }
+    elapsed = now_seconds() - start;
+    sink = acc;
+
+    printf("  getKeysPressed %10.0f decodes/s %6.1f ns/decode (all 65536 "
+           "keystates)\n",
+           DECODE_ITERATIONS * 65536.0 / elapsed,
+           elapsed * 1e9 / (DECODE_ITERATIONS * 65536.0));
+}
+
+static void bench_debounce(void) {
+    KYPD_Event event;
+    double start, elapsed;
+    u32 acc = 0;
+    u32 i, down;
+
+    reset_keypad(KYPD_SCAN_COLUMN_WALK);
+    start = now_seconds();
+    for (i = 0; i < SAMPLE_ITERATIONS; i++) {
+        // A different key goes down, then up, every 16 samples and bounces
+        // once on each edge
+        down = ((i >> 4) & 0x1) ^ ((i & 0xF) == 1);
+        acc += KYPD_processKeyStates(&KYPDInst, down ? 1 << ((i >> 5) & 0xF) : 0,
+                                     i * KYPD_POLL_PERIOD);
+        while (KYPD_readEvent(&KYPDInst, &event) == XST_SUCCESS)
+            acc += event.key;
+    }
+    elapsed = now_seconds() - start;
+    sink = acc;
+
+    printf("  processKeyStates %8.0f samples/s %5.1f ns/sample\n",
+           SAMPLE_ITERATIONS / elapsed, elapsed * 1e9 / SAMPLE_ITERATIONS);
+}
+
+int main(void) {
+    u32 mode;
+
+    printf("decode correctness\n");
+    for (mode = KYPD_SCAN_COLUMN_WALK; mode <= KYPD_SCAN_SHIFT_PATTERN;
+         mode++) {
+        reset_keypad(mode);
+        check(check_single_keys(mode), mode_names[mode], "single keys");
+        // The shift pattern decoder cannot resolve chords, only report it
+        if (!check_chords(mode) && mode == KYPD_SCAN_COLUMN_WALK)
+            check(FALSE, mode_names[mode], "chords");
+        check(check_debounce(mode), mode_names[mode], "debounce");
+    }
+
+    printf("\nscan throughput (%u scans, one key held)\n", SCAN_ITERATIONS);
+    for (mode = KYPD_SCAN_COLUMN_WALK; mode <= KYPD_SCAN_SHIFT_PATTERN; mode++)
+        bench_scan(mode);
+
+    printf("\ndecode / debounce throughput\n");
+    bench_decode();
+    bench_debounce();
+
+    printf("\n%s (%u failures)\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
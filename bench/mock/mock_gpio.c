@@ -0,0 +1,81 @@
+/*
+ * mock_gpio.c
+ * Mocked AXI GPIO register file with a PmodKYPD matrix behind it.
+ *
+ * Channel 1 of the GPIO drives the four columns on bits 0-3 and reads the
+ * four rows on bits 4-7. Rows are pulled up and read low when they connect
+ * to a low column through pressed keys. Like the real keypad the matrix has
+ * no diodes, so three keys on the corners of a rectangle also pull down the
+ * fourth corner (ghosting).
+ */
+
+#include "mock_gpio.h"
+#include "xil_io.h"
+
+#define GPIO_DATA_OFFSET 0x000
+#define GPIO_TRI_OFFSET  0x004
+
+static u32 cols  = 0xF;
+static u32 tri   = 0xFFFFFFFF;
+static u16 keys  = 0;
+static u32 reads = 0;
+static u32 writes = 0;
+
+// Rows connected to one of the low columns through pressed keys
+static u32 low_rows(u32 low_cols) {
+    u32 rows = 0, prev_rows, prev_cols;
+    u32 r, c;
+
+    do {
+        prev_rows = rows;
+        prev_cols = low_cols;
+        for (r = 0; r < 4; r++) {
+            for (c = 0; c < 4; c++) {
+                // Column c sits on bit (3 - c) of each row nibble
+                if ((keys >> (4 * r + (3 - c)) & 0x1) == 0) continue;
+                if (low_cols & (1 << c)) rows |= 1 << r;
+                if (rows & (1 << r)) low_cols |= 1 << c;
+            }
+        }
+    } while (rows != prev_rows || low_cols != prev_cols);
+
+    return rows;
+}
+
+u32 Xil_In32(u32 Addr) {
+    u32 rows;
+
+    if (Addr == MOCK_KYPD_BASEADDR + GPIO_DATA_OFFSET) {
+        ++reads;
+        rows = ~low_rows(~cols & 0xF) & 0xF;
+        return (rows << 4) | cols;
+    }
+    if (Addr == MOCK_KYPD_BASEADDR + GPIO_TRI_OFFSET) {
+        ++reads;
+        return tri;
+    }
+    return 0;
+}
+
+void Xil_Out32(u32 Addr, u32 Value) {
+    if (Addr == MOCK_KYPD_BASEADDR + GPIO_DATA_OFFSET) {
+        ++writes;
+        cols = Value & 0xF;
+    } else if (Addr == MOCK_KYPD_BASEADDR + GPIO_TRI_OFFSET) {
+        ++writes;
+        tri = Value;
+    }
+}
+
+void mock_kypd_press(u16 pressed) { keys = pressed; }
+
+u16 mock_kypd_pressed(void) { return keys; }
+
+void mock_gpio_reset_counts(void) {
+    reads  = 0;
+    writes = 0;
+}
+
+u32 mock_gpio_reads(void) { return reads; }
+
+u32 mock_gpio_writes(void) { return writes; }
@@ -0,0 +1,22 @@
+/*
+ * mock_gpio.h
+ * Mocked AXI GPIO register file with a PmodKYPD matrix behind it.
+ */
+
+#ifndef MOCK_GPIO_H
+#define MOCK_GPIO_H
+
+#include "xil_types.h"
+
+#define MOCK_KYPD_BASEADDR 0x41200000
+
+// Keys held down on the simulated keypad, same bit layout as the keystate
+void mock_kypd_press(u16 keys);
+u16 mock_kypd_pressed(void);
+
+// Register accesses seen since the last reset
+void mock_gpio_reset_counts(void);
+u32 mock_gpio_reads(void);
+u32 mock_gpio_writes(void);
+
+#endif /* MOCK_GPIO_H */
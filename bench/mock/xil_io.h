@@ -0,0 +1,15 @@
+/*
+ * xil_io.h
+ * Host stand-in for the Xilinx BSP header. Register accesses are routed to
+ * the mocked register file in mock_gpio.c.
+ */
+
+#ifndef XIL_IO_H
+#define XIL_IO_H
+
+#include "xil_types.h"
+
+u32 Xil_In32(u32 Addr);
+void Xil_Out32(u32 Addr, u32 Value);
+
+#endif /* XIL_IO_H */
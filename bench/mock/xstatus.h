@@ -0,0 +1,17 @@
+/*
+ * xstatus.h
+ * Host stand-in for the Xilinx BSP header.
+ */
+
+#ifndef XSTATUS_H
+#define XSTATUS_H
+
+#include "xil_types.h"
+
+typedef s32 XStatus;
+
+#define XST_SUCCESS 0L
+#define XST_FAILURE 1L
+#define XST_NO_DATA 13L
+
+#endif /* XSTATUS_H */
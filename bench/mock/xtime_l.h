@@ -0,0 +1,27 @@
+/*
+ * xtime_l.h
+ * Host stand-in for the Xilinx BSP header. The global timer is replaced by
+ * CLOCK_MONOTONIC, ticking at the Zynq's CPU_1x rate so the counts look the
+ * same as on the board.
+ */
+
+#ifndef XTIME_L_H
+#define XTIME_L_H
+
+#include <time.h>
+
+#include "xil_types.h"
+
+typedef u64 XTime;
+
+#define COUNTS_PER_SECOND 333333333ULL
+
+static inline void XTime_GetTime(XTime *Xtime_Global) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    *Xtime_Global = (u64)ts.tv_sec * COUNTS_PER_SECOND +
+                    (u64)ts.tv_nsec * COUNTS_PER_SECOND / 1000000000ULL;
+}
+
+#endif /* XTIME_L_H */
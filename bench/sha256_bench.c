@@ -0,0 +1,422 @@
+/*
+ * sha256_bench.c
+ * Host conformance checks and benchmark for the lab2/part1 SHA-256.
+ *
+ * Checks:
+ *  - the FIPS 180-4 example messages, short messages from the NIST SHAVS
+ *    byte-oriented vectors, and one million 'a', the long-message case
+ *  - any split of a message across sha256Update() calls
+ *  - sha256Update() against the original byte-at-a-time loop, kept here as
+ *    the reference
+ *  - every sha256_x4 lane against single hashes, equal and unequal lengths
+ *
+ * Then times Init + Update + Final, best of BENCH_TRIALS, for message sizes
+ * from 16 B to 1 MB at buffer offsets 0-3, the reference update, and four
+ * short messages at a time through sha256_x4. Each row has MB/s and, on
+ * x86, TSC cycles per byte.
+ *
+ * bench_sha256_rolled is the same program built with SHA256_UNROLLED=0, the
+ * original compression loop, so the two kernels can be compared.
+ *
+ * Usage: bench_sha256 [--json]
+ * --json prints the results as one JSON object on stdout, the progress
+ * lines go to stderr.
+ *
+ * Exits non-zero if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#include "sha256.h"
+#include "sha256_x4.h"
+
+#define BENCH_BYTES  (4u << 20) // Hashed per trial, spread over the messages
+#define BENCH_TRIALS 5          // Best trial counts, the host is shared
+#define BENCH_ALIGNS 4          // Buffer offsets 0 to 3
+#define MAX_RESULTS  64
+
+#if !defined(SHA256_UNROLLED) || SHA256_UNROLLED
+#define KERNEL "unrolled"
+#else
+#define KERNEL "rolled"
+#endif
+
+// Not in sha256.h, the reference update below needs it
+void sha256Transform(SHA256_CTX *ctx, const BYTE data[]);
+
+static unsigned failures;
+static FILE *report; // Human-readable output, stderr with --json
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void check(int ok, const char *what) {
+    if (!ok) {
+        fprintf(report, "  FAIL %s\n", what);
+        ++failures;
+    }
+}
+
+// The original sha256Update(), one byte into ctx->data at a time
+static void ref_update(SHA256_CTX *ctx, const BYTE data[], size_t len) {
+    size_t i;
+
+    for (i = 0; i < len; ++i) {
+        ctx->data[ctx->datalen] = data[i];
+        ctx->datalen++;
+        if (ctx->datalen == 64) {
+            sha256Transform(ctx, ctx->data);
+            ctx->bitlen += 512;
+            ctx->datalen = 0;
+        }
+    }
+}
+
+typedef void (*update_fn)(SHA256_CTX *ctx, const BYTE data[], size_t len);
+
+static void digest(update_fn update, const BYTE *data, size_t len,
+                   BYTE out[SHA256_BLOCK_SIZE]) {
+    SHA256_CTX ctx;
+
+    sha256Init(&ctx);
+    update(&ctx, data, len);
+    sha256Final(&ctx, out);
+}
+
+static void to_hex(const BYTE *hash, char *hex) {
+    int i;
+
+    for (i = 0; i < SHA256_BLOCK_SIZE; i++) {
+        sprintf(&hex[i * 2], "%02x", hash[i]);
+    }
+}
+
+// FIPS 180-4 examples, then SHAVS SHA256ShortMsg
+typedef struct {
+    const char *msg;
+    size_t len;
+    const char *hex;
+} vector_t;
+
+#define VECTOR(msg, hex) {msg, sizeof(msg) - 1, hex}
+
+static const vector_t vectors[] = {
+    VECTOR("",
+           "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"),
+    VECTOR("abc",
+           "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"),
+    VECTOR("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+           "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"),
+    VECTOR("abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+           "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+           "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"),
+    VECTOR("\xd3",
+           "28969cdfa74a12c82f3bad960b0b000aca2ac329deea5c2328ebc6f2ba9802c1"),
+    VECTOR("\x11\xaf",
+           "5ca7133fa735326081558ac312c620eeca9970d1e70a4b95533d956f072d1f98"),
+    VECTOR("\xb4\x19\x0e",
+           "dff2e73091f6c05e528896c4c831b9448653dc2ff043528f6769437bc7b975c2"),
+    VECTOR("\x74\xba\x25\x21",
+           "b16aa56be3880d18cd41e68384cf1ec8c17680c45a02b1575dc1518923ae8b0e"),
+};
+
+#define MILLION_A_HEX                                                         \
+    "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"
+
+static void check_vectors(void) {
+    BYTE hash[SHA256_BLOCK_SIZE], block[1000];
+    char hex[SHA256_BLOCK_SIZE * 2 + 1];
+    SHA256_CTX ctx;
+    size_t i;
+    unsigned before = failures;
+    char what[32];
+
+    for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+        digest(sha256Update, (const BYTE *)vectors[i].msg, vectors[i].len,
+               hash);
+        to_hex(hash, hex);
+        snprintf(what, sizeof(what), "vector %zu", i);
+        check(strcmp(hex, vectors[i].hex) == 0, what);
+    }
+
+    // In 1000-byte updates, off the 64-byte block boundary
+    memset(block, 'a', sizeof(block));
+    sha256Init(&ctx);
+    for (i = 0; i < 1000; i++) {
+        sha256Update(&ctx, block, sizeof(block));
+    }
+    sha256Final(&ctx, hash);
+    to_hex(hash, hex);
+    check(strcmp(hex, MILLION_A_HEX) == 0, "one million 'a'");
+
+    fprintf(report, "NIST vectors: %s\n",
+            failures == before ? "ok" : "FAILED");
+}
+
+// Every length up to four blocks, fed in chunks of every size up to 70
+static void check_splits(void) {
+    BYTE data[256], want[SHA256_BLOCK_SIZE], got[SHA256_BLOCK_SIZE];
+    SHA256_CTX ctx;
+    size_t len, chunk, pos, n;
+    unsigned before = failures;
+    char what[64];
+
+    for (pos = 0; pos < sizeof(data); pos++) {
+        data[pos] = (BYTE)(pos * 131 + 7);
+    }
+
+    for (len = 0; len <= sizeof(data); len++) {
+        digest(ref_update, data, len, want);
+
+        digest(sha256Update, data, len, got);
+        snprintf(what, sizeof(what), "%zu bytes against the reference", len);
+        check(memcmp(want, got, sizeof(want)) == 0, what);
+
+        for (chunk = 1; chunk <= 70; chunk++) {
+            sha256Init(&ctx);
+            for (pos = 0; pos < len; pos += n) {
+                n = len - pos < chunk ? len - pos : chunk;
+                sha256Update(&ctx, &data[pos], n);
+            }
+            sha256Final(&ctx, got);
+
+            snprintf(what, sizeof(what), "%zu bytes in %zu-byte chunks", len,
+                     chunk);
+            check(memcmp(want, got, sizeof(want)) == 0, what);
+        }
+    }
+
+    fprintf(report, "Split updates: %s\n",
+            failures == before ? "ok" : "FAILED");
+}
+
+// Random lane lengths up to five blocks, each lane fed in one or two updates
+static void check_x4(void) {
+    BYTE data[SHA256_X4_LANES][320], want[SHA256_BLOCK_SIZE];
+    BYTE got[SHA256_X4_LANES][SHA256_BLOCK_SIZE];
+    const BYTE *ptr[SHA256_X4_LANES];
+    size_t len[SHA256_X4_LANES], first[SHA256_X4_LANES], rest[SHA256_X4_LANES];
+    SHA256_X4_CTX ctx;
+    unsigned seed = 1, round, before = failures;
+    int l, same;
+    size_t i;
+    char what[64];
+
+    for (l = 0; l < SHA256_X4_LANES; l++) {
+        for (i = 0; i < sizeof(data[l]); i++) {
+            data[l][i] = (BYTE)(i * 131 + 7 + l * 17);
+        }
+    }
+
+    for (round = 0; round < 20000; round++) {
+        same = round % 2; // Half the rounds use one length for all lanes
+        for (l = 0; l < SHA256_X4_LANES; l++) {
+            seed   = seed * 1103515245u + 12345u;
+            len[l] = (same && l > 0) ? len[0] : (seed >> 8) % sizeof(data[l]);
+            first[l] = (round % 3 == 0) ? (seed >> 20) % (len[l] + 1) : len[l];
+            rest[l]  = len[l] - first[l];
+        }
+
+        sha256_x4_init(&ctx);
+        for (l = 0; l < SHA256_X4_LANES; l++) {
+            ptr[l] = data[l];
+        }
+        sha256_x4_update(&ctx, ptr, first);
+        for (l = 0; l < SHA256_X4_LANES; l++) {
+            ptr[l] = &data[l][first[l]];
+        }
+        sha256_x4_update(&ctx, ptr, rest);
+        sha256_x4_final(&ctx, got);
+
+        for (l = 0; l < SHA256_X4_LANES; l++) {
+            digest(sha256Update, data[l], len[l], want);
+            snprintf(what, sizeof(what), "x4 lane %d, %zu bytes", l, len[l]);
+            check(memcmp(want, got[l], sizeof(want)) == 0, what);
+        }
+    }
+
+    fprintf(report, "Multi-buffer lanes: %s\n",
+            failures == before ? "ok" : "FAILED");
+}
+
+// -------------------------------------------------
+// Timing
+// -------------------------------------------------
+
+typedef enum { PATH_UPDATE, PATH_REFERENCE, PATH_X4 } path_t;
+
+static const char *const path_names[] = {"update", "reference", "x4"};
+
+typedef struct {
+    path_t path;
+    size_t size;
+    size_t align;
+    double mb_s;
+    double hashes_s;
+    double cycles_per_byte; // 0 without a TSC
+} result_t;
+
+static result_t results[MAX_RESULTS];
+static size_t result_count;
+
+static unsigned long long cycles(void) {
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Hashes BENCH_BYTES as messages of len bytes, four at a time for PATH_X4,
+// which needs 4 * len bytes of data
+static void run(path_t path, const BYTE *data, size_t len) {
+    BYTE hash[SHA256_BLOCK_SIZE], hashes[SHA256_X4_LANES][SHA256_BLOCK_SIZE];
+    const BYTE *ptr[SHA256_X4_LANES];
+    size_t lens[SHA256_X4_LANES];
+    SHA256_X4_CTX ctx;
+    volatile BYTE sink = 0;
+    size_t i, count = BENCH_BYTES / len;
+    int l;
+
+    switch (path) {
+    case PATH_UPDATE:
+    case PATH_REFERENCE:
+        for (i = 0; i < count; i++) {
+            digest(path == PATH_UPDATE ? sha256Update : ref_update, data, len,
+                   hash);
+            sink ^= hash[0];
+        }
+        break;
+
+    case PATH_X4:
+        for (l = 0; l < SHA256_X4_LANES; l++) {
+            ptr[l]  = data + l * len;
+            lens[l] = len;
+        }
+        for (i = 0; i < count; i += SHA256_X4_LANES) {
+            sha256_x4_init(&ctx);
+            sha256_x4_update(&ctx, ptr, lens);
+            sha256_x4_final(&ctx, hashes);
+            sink ^= hashes[0][0];
+        }
+        break;
+    }
+    (void)sink;
+}
+
+static void measure(path_t path, const BYTE *data, size_t len, size_t align) {
+    result_t *r;
+    double start, elapsed, best = 0;
+    unsigned long long c0, c, best_cycles = 0;
+    size_t bytes = BENCH_BYTES / len * len;
+    int trial;
+
+    if (result_count == MAX_RESULTS) return;
+
+    for (trial = 0; trial < BENCH_TRIALS; trial++) {
+        c0    = cycles();
+        start = now_s();
+        run(path, data + align, len);
+        elapsed = now_s() - start;
+        c       = cycles() - c0;
+        if (trial == 0 || elapsed < best) {
+            best        = elapsed;
+            best_cycles = c;
+        }
+    }
+
+    r                  = &results[result_count++];
+    r->path            = path;
+    r->size            = len;
+    r->align           = align;
+    r->mb_s            = bytes / best / 1e6;
+    r->hashes_s        = bytes / len / best;
+    r->cycles_per_byte = HAVE_TSC ? (double)best_cycles / bytes : 0;
+
+    fprintf(report, "%-10s %8zu %6zu %10.1f %12.0f %8.2f\n",
+            path_names[path], len, align, r->mb_s, r->hashes_s,
+            r->cycles_per_byte);
+}
+
+static void print_json(void) {
+    size_t i;
+
+    printf("{\n  \"kernel\": \"%s\",\n  \"x4_engine\": \"%s\",\n", KERNEL,
+           SHA256_X4_ENGINE);
+    printf("  \"checks\": \"%s\",\n  \"cycles\": \"%s\",\n",
+           failures ? "fail" : "pass", HAVE_TSC ? "tsc" : "none");
+    printf("  \"results\": [\n");
+    for (i = 0; i < result_count; i++) {
+        printf("    {\"path\": \"%s\", \"size\": %zu, \"align\": %zu, "
+               "\"mb_s\": %.2f, \"hashes_s\": %.0f, "
+               "\"cycles_per_byte\": ",
+               path_names[results[i].path], results[i].size, results[i].align,
+               results[i].mb_s, results[i].hashes_s);
+        if (HAVE_TSC) {
+            printf("%.3f}", results[i].cycles_per_byte);
+        } else {
+            printf("null}");
+        }
+        printf("%s\n", i + 1 < result_count ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+int main(int argc, char **argv) {
+    static const size_t sizes[] = {16, 64, 256, 1024, 8u << 10, 64u << 10,
+                                   1u << 20};
+    static const size_t x4_sizes[] = {16, 55, 64, 256, 512};
+    size_t data_len = (1u << 20) + BENCH_ALIGNS;
+    int json = argc > 1 && strcmp(argv[1], "--json") == 0;
+    BYTE *data;
+    size_t i, align;
+
+    report = json ? stderr : stdout;
+
+    fprintf(report, "Kernel: %s, multi-buffer engine: %s\n", KERNEL,
+            SHA256_X4_ENGINE);
+
+    check_vectors();
+    check_splits();
+    check_x4();
+
+    data = malloc(data_len);
+    if (data == NULL) return 1;
+    for (i = 0; i < data_len; i++) {
+        data[i] = (BYTE)(i * 131 + 7);
+    }
+
+    fprintf(report, "\n%-10s %8s %6s %10s %12s %8s\n", "path", "size",
+            "align", "MB/s", "hash/s", HAVE_TSC ? "cyc/B" : "-");
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (align = 0; align < BENCH_ALIGNS; align++) {
+            measure(PATH_UPDATE, data, sizes[i], align);
+        }
+    }
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        measure(PATH_REFERENCE, data, sizes[i], 0);
+    }
+    for (i = 0; i < sizeof(x4_sizes) / sizeof(x4_sizes[0]); i++) {
+        measure(PATH_X4, data, x4_sizes[i], 0);
+    }
+
+    free(data);
+
+    if (json) print_json();
+
+    fprintf(report, "\n%s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
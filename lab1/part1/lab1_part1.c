@@ -9,9 +9,9 @@
  *
  * Summary:
  * 1) Declare & initialize the 7-seg display (SSD).
- * 2) Use xDelay to alternate between two digits fast enough to prevent flicker.
+ * 2) Write both digits to the SSD driver, which multiplexes them from a timer interrupt.
  * 3) Output pressed keypad digits on both SSD digits: current_key on right, previous_key on left.
- * 4) Print status changes and experiment with xDelay to find minimum flicker-free frequency.
+ * 4) Print status changes.
  *
  * Deliverables:
  * - Demonstrate correct display of current and previous keys with no flicker.
@@ -35,6 +35,7 @@
 
 // Other miscellaneous libraries
 #include "pmodkypd.h"
+#include "ssd_driver.h"
 
 
 // Device ID declarations
@@ -47,21 +48,15 @@
 // keypad key table
 #define DEFAULT_KEYTABLE 	"0FED789C456B123A"
 
-// SSD channel (subject to change)
-#define SSD_CHANNEL			1
-
 // Declaring the devices
 PmodKYPD 	KYPDInst;
 
-/*************************** Enter your code here ****************************/
-// TODO: Declare the seven-segment display peripheral here.
-XGpio		SSDInst;
-/*****************************************************************************/
+// GIC instance set up by the FreeRTOS port when the scheduler starts
+extern XScuGic xInterruptController;
 
 // Function prototypes
 void InitializeKeypad();
 static void vKeypadTask( void *pvParameters );
-u32 SSD_decode(u8 key_value, u8 cathode);
 
 
 int main(void)
@@ -73,8 +68,7 @@ int main(void)
 
 /*************************** Enter your code here ****************************/
 	// TODO: Initialize SSD and set the GPIO direction to output.
-	XGpio_Initialize(&SSDInst, SSD_DEVICE_ID);
-	XGpio_SetDataDirection(&SSDInst, SSD_CHANNEL, 0x0); // sets all pins as outputs
+	SSD_begin(SSD_DEVICE_ID);
 /*****************************************************************************/
 
 	xil_printf("Initialization Complete, System Ready!\n");
@@ -97,14 +91,18 @@ static void vKeypadTask( void *pvParameters )
 	u16 keystate;
 	XStatus status, previous_status = KYPD_NO_KEY;
 	u8 new_key, current_key = 'x', previous_key = 'x';
-	u32 ssd_value=0;
 
 /*************************** Enter your code here ****************************/
 	// TODO: Define a constant of type TickType_t named 'xDelay' and initialize
 	//       it with a value of 100.
-	const TickType_t xDelay = 12; // portticks
+	const TickType_t xDelay = 12; // portticks, keypad polling period
 /*****************************************************************************/
 
+	// The SSD is refreshed from the TTC interrupt, this task only updates it
+	if (SSD_startRefresh(&xInterruptController) != XST_SUCCESS) {
+		xil_printf("SSD refresh timer setup failed\r\n");
+	}
+
     xil_printf("Pmod KYPD app started. Press any key on the Keypad.\r\n");
 	while (1){
 		// Capture state of the keypad
@@ -134,19 +132,13 @@ static void vKeypadTask( void *pvParameters )
 		previous_status = status;
 
 /*************************** Enter your code here ****************************/
-		/* TODO: Decode the current and previous keys using the `SSD_decode` function.
-		* Write each decoded value to the seven-segment display, one at a time,
-		* using the `XGpio_DiscreteWrite` function.
-		* Add a delay between updates for persistence of vision using `vTaskDelay`.
+		/* TODO: Show the previous and current keys using the `SSD_showChars`
+		* function. It encodes both keys into the SSD framebuffer, the SSD driver
+		* multiplexes the digits from its timer interrupt.
 		*/
-		
 
         // NOTE: The SSD is upside down on the zybo...
-		ssd_value = SSD_decode(current_key, (u8) 1); // right side, cat = 0
-		XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, ssd_value);
-		vTaskDelay(xDelay);
-		ssd_value = SSD_decode(previous_key, (u8) 0); // left side, cat = 1
-		XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, ssd_value);
+		SSD_showChars(previous_key, current_key); // left side, right side
 		vTaskDelay(xDelay);
 
 /*****************************************************************************/
@@ -159,38 +151,3 @@ void InitializeKeypad()
 	KYPD_begin(&KYPDInst, KYPD_DEVICE_ID);
 	KYPD_loadKeyTable(&KYPDInst, (u8*) DEFAULT_KEYTABLE);
 }
-
-// This function is hard coded to translate key value codes to their binary representation
-u32 SSD_decode(u8 key_value, u8 cathode)
-{
-    u32 result;
-
-	// key_value represents the code of the pressed key
-	switch(key_value){ // Handles the coding of the 7-seg display
-		case 48: result = 0b00111111; break; // 0
-        case 49: result = 0b00110000; break; // 1
-        case 50: result = 0b01011011; break; // 2
-        case 51: result = 0b01111001; break; // 3
-        case 52: result = 0b01110100; break; // 4
-        case 53: result = 0b01101101; break; // 5
-        case 54: result = 0b01101111; break; // 6
-        case 55: result = 0b00111000; break; // 7
-        case 56: result = 0b01111111; break; // 8
-        case 57: result = 0b01111100; break; // 9
-        case 65: result = 0b01111110; break; // A
-        case 66: result = 0b01100111; break; // B
-        case 67: result = 0b00001111; break; // C
-        case 68: result = 0b01110011; break; // D
-        case 69: result = 0b01001111; break; // E
-        case 70: result = 0b01001110; break; // F
-        default: result = 0b00000000; break; // default case - all seven segments are OFF
-    }
-
-	// cathode handles which display is active (left or right)
-	// by setting the MSB to 1 or 0
-    if(cathode==0){
-            return result;
-    } else {
-            return result | 0b10000000;
-	}
-}
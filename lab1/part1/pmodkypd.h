@@ -7,17 +7,74 @@
 #include "xstatus.h"
 #include "xil_types.h"
 
+#ifndef KYPD_NO_RTOS
+#include "FreeRTOS.h"
+#include "task.h"
+#endif
+
 /**************************** Type Definitions **************************/
 
+#define KYPD_EVENT_QUEUE_LEN  16 // Must be a power of two
+#define KYPD_DEBOUNCE_SAMPLES 3  // Consecutive samples needed to change state
+
+#ifndef KYPD_NO_RTOS
+#define KYPD_TICKS(ms) pdMS_TO_TICKS(ms)
+#else
+#define KYPD_TICKS(ms) (ms) // Host builds count time in milliseconds
+#endif
+
+#define KYPD_POLL_PERIOD   KYPD_TICKS(10)  // Debounce sample period
+#define KYPD_REPEAT_DELAY  KYPD_TICKS(500) // Hold time before auto-repeat
+#define KYPD_REPEAT_PERIOD KYPD_TICKS(100) // Auto-repeat interval
+
+#define KYPD_EVENT_PRESS   0
+#define KYPD_EVENT_RELEASE 1
+#define KYPD_EVENT_REPEAT  2
+
+typedef struct KYPD_Event {
+   u8  key;   // Key label when the keytable is loaded, key index otherwise
+   u8  index; // Bit position of the key in the keystate
+   u8  type;  // KYPD_EVENT_PRESS, KYPD_EVENT_RELEASE or KYPD_EVENT_REPEAT
+   u32 tick;  // Tick count when the event was detected
+} KYPD_Event;
+
 typedef struct PmodKYPD {
    u32 GPIO_addr;
    u8  keytable[16];
    u32 keytable_loaded;
+   u32 scan_mode;              // KYPD_SCAN_COLUMN_WALK or KYPD_SCAN_SHIFT_PATTERN
+   u32 scan_cost;              // GPIO transactions used by the last scan
+#ifndef KYPD_NO_RTOS
+   TaskHandle_t notify_task;   // Task woken by KYPD_InterruptHandler
+#endif
+   volatile u16 last_keystate; // Keystate captured by the last interrupt scan
+   u8  integrator[16];         // Per-key debounce integrators
+   u16 debounced;              // Debounced keystate
+   u16 unsettled;              // Keys whose integrator is between the rails
+   u32 repeat_tick;            // Tick of the next auto-repeat
+   KYPD_Event events[KYPD_EVENT_QUEUE_LEN];
+   u32 event_head;             // Next slot to write
+   u32 event_tail;             // Next slot to read
+   u32 events_dropped;         // Events lost to a full queue
 } PmodKYPD;
 
 #define KYPD_NO_KEY     0
 #define KYPD_SINGLE_KEY 1
 #define KYPD_MULTI_KEY  2
+#define KYPD_GHOST_KEY  3 // Keys form a rectangle, one of them may be a ghost
+
+#define KYPD_SCAN_COLUMN_WALK   0 // 4 column writes + 4 row reads
+#define KYPD_SCAN_SHIFT_PATTERN 1 // 16 column patterns, legacy decoder
+
+// AXI GPIO register offsets (PG144), the keypad lives on channel 1
+#define KYPD_GPIO_DATA_OFFSET 0x000
+#define KYPD_GPIO_TRI_OFFSET  0x004
+#define KYPD_GPIO_GIER_OFFSET 0x11C
+#define KYPD_GPIO_ISR_OFFSET  0x120
+#define KYPD_GPIO_IER_OFFSET  0x128
+
+#define KYPD_GPIO_GIE_MASK    0x80000000
+#define KYPD_GPIO_CH1_MASK    0x1
 
 /************************** Function Definitions ************************/
 
@@ -26,6 +83,27 @@ void KYPD_loadKeyTable(PmodKYPD *InstancePtr, u8 keytable[16]);
 void KYPD_setCols(PmodKYPD *InstancePtr, u32 cols);
 u32 KYPD_getRows(PmodKYPD *InstancePtr);
 u16 KYPD_getKeyStates(PmodKYPD *InstancePtr);
+void KYPD_setScanMode(PmodKYPD *InstancePtr, u32 mode);
+u32 KYPD_getScanCost(PmodKYPD *InstancePtr);
 u32 KYPD_getKeyPressed(PmodKYPD *InstancePtr, u16 keystate, u8 *cptr);
+u32 KYPD_getKeysPressed(PmodKYPD *InstancePtr, u16 keystate, u8 keys[16],
+                        u32 *count);
+u32 KYPD_countKeys(u16 keystate);
+u32 KYPD_nextKey(u16 *keyset);
+u32 KYPD_isGhosted(u16 keystate);
+u32 KYPD_processKeyStates(PmodKYPD *InstancePtr, u16 keystate, u32 now);
+u32 KYPD_pollEvents(PmodKYPD *InstancePtr, u32 now);
+XStatus KYPD_readEvent(PmodKYPD *InstancePtr, KYPD_Event *event);
+u16 KYPD_getDebouncedKeyStates(PmodKYPD *InstancePtr);
+
+#ifndef KYPD_NO_RTOS
+void KYPD_enableInterrupt(PmodKYPD *InstancePtr, TaskHandle_t NotifyTask);
+void KYPD_disableInterrupt(PmodKYPD *InstancePtr);
+void KYPD_InterruptHandler(void *CallBackRef);
+XStatus KYPD_waitKeyStates(PmodKYPD *InstancePtr, TickType_t timeout,
+                           u16 *keystate);
+XStatus KYPD_waitEvent(PmodKYPD *InstancePtr, KYPD_Event *event,
+                       TickType_t timeout);
+#endif
 
 #endif // PmodKYPD_H
@@ -0,0 +1,63 @@
+/*
+ * ssd_driver.h
+ *
+ * Seven-segment display driver. The two digits share one set of segment
+ * lines, so they are multiplexed from a TTC interval interrupt that shows
+ * the next digit of a small framebuffer on every tick. Tasks only update the
+ * framebuffer and never touch the GPIO.
+ *
+ * Characters are encoded once, through a 128-entry glyph table, when they are
+ * written to the framebuffer, so the refresh only copies bytes.
+ */
+
+#ifndef SSD_DRIVER_H_
+#define SSD_DRIVER_H_
+
+#include "xil_io.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xparameters.h"
+#include "xscugic.h"
+
+// Macros
+#define SSD_TIMER_BASEADDR XPAR_XTTCPS_0_BASEADDR // TTC0, counter 0
+#define SSD_TIMER_IRQ_ID   XPS_TTC0_0_INT_ID
+#define SSD_REFRESH_HZ     1000 // Digit switches per second, 500 Hz per digit
+
+#define SSD_GPIO_DATA_OFFSET 0x000 // AXI GPIO channel 1 (PG144)
+#define SSD_GPIO_TRI_OFFSET  0x004
+
+// Segment bits as wired on the Pmod SSD, SSD_GLYPH() in ssd_driver.c builds
+// every SSD_glyphs entry from these
+#define SSD_SEG_A 0x08 // top
+#define SSD_SEG_B 0x10 // top right
+#define SSD_SEG_C 0x20 // bottom right
+#define SSD_SEG_D 0x01 // bottom
+#define SSD_SEG_E 0x02 // bottom left
+#define SSD_SEG_F 0x04 // top left
+#define SSD_SEG_G 0x40 // middle
+
+#define SSD_SEGMENT_MASK 0x7F
+#define SSD_CATHODE_MASK 0x80 // Set to light the right digit
+
+#define SSD_DIGIT_LEFT  0
+#define SSD_DIGIT_RIGHT 1
+#define SSD_NUM_DIGITS  2
+
+// Segment patterns for ASCII, blank for characters with no glyph
+extern const u8 SSD_glyphs[128];
+
+// Function prototypes
+void SSD_begin(u32 GpioBaseAddress);
+int SSD_startRefresh(XScuGic *IntcInstancePtr);
+void SSD_stopRefresh(void);
+void SSD_setDigit(u32 digit, u8 segments);
+void SSD_setDigits(u8 left, u8 right);
+void SSD_clear(void);
+u8 SSD_encode(u8 c);
+void SSD_showChars(u8 left, u8 right);
+void SSD_showDecimal(u32 value);
+void SSD_showHex(u8 value);
+void SSD_interruptHandler(void *CallBackRef);
+
+#endif /* SSD_DRIVER_H_ */
@@ -0,0 +1,91 @@
+/*
+ * dlog.h
+ *
+ * Deferred logging. A call site stores a fixed-size binary record, the
+ * format ID, a timestamp and up to DLOG_MAX_ARGS 32-bit arguments, in a
+ * lock-free RAM ring and returns. A low-priority task formats the records
+ * and writes them to the UART when nothing more urgent is running.
+ *
+ * The format strings live in each lab's dlog_formats.h. The host decoder in
+ * bench/dlog_decode.c is built against the same table, so a raw dump of the
+ * ring (or of the UART in DLOG_BINARY mode) can be expanded offline.
+ *
+ * Supported conversions: %d %i %u %x %X %c %% and %D, which prints a value
+ * given in tenths as "12.5". Width and the 0 flag work, strings and floats
+ * do not, pass floats through DLOG_TENTHS().
+ */
+
+#ifndef DLOG_H_
+#define DLOG_H_
+
+#include "xil_types.h"
+
+#include <stddef.h>
+
+#ifndef DLOG_NO_RTOS
+#include "FreeRTOS.h"
+#endif
+
+#include "dlog_formats.h"
+
+// Macros
+#define DLOG_MAX_ARGS     5
+#define DLOG_RING_LEN     128U // Records, must be a power of two
+#define DLOG_LINE_LEN     128  // Longest formatted message
+#define DLOG_DRAIN_PERIOD 10   // ms between drains when the ring is empty
+#define DLOG_MAGIC        0xD1
+
+// 1 sends the raw records instead of text, for bench/dlog_decode.c
+#ifndef DLOG_BINARY
+#define DLOG_BINARY 0
+#endif
+
+#if (DLOG_RING_LEN & (DLOG_RING_LEN - 1U)) != 0U
+#error "DLOG_RING_LEN must be a power of two"
+#endif
+
+// Format IDs, DLOG_DROPPED is built in and DLOG_FORMAT_COUNT is one past
+// the last
+#define DLOG_ID(id, fmt) id,
+enum { DLOG_DROPPED, DLOG_FORMATS(DLOG_ID) DLOG_FORMAT_COUNT };
+#undef DLOG_ID
+
+// One 32-byte record, little-endian in memory and on the wire
+typedef struct {
+    u32 seq;       // Ring position + 1, written last to commit the record
+    u32 timestamp; // Global timer counts, low word
+    u16 id;        // Format ID
+    u8 argc;
+    u8 magic; // DLOG_MAGIC, lets the decoder find records in a raw dump
+    u32 args[DLOG_MAX_ARGS];
+} DlogRecord;
+
+// Formatted output goes here, called from the drain task only
+typedef void (*DlogSink)(const char *buf, size_t len);
+
+// Fixed point for %D, rounds to the nearest tenth
+#define DLOG_TENTHS(x) ((s32)((x) * 10.0f + (((x) < 0) ? -0.5f : 0.5f)))
+
+// DLOG(id, args...) logs from a task or an interrupt handler. Arguments are
+// converted to u32, signed values come back out of %d unchanged.
+#define DLOG(id, ...)                                                         \
+    do {                                                                      \
+        const u32 dlog_args_[] = {0, ##__VA_ARGS__};                          \
+        _Static_assert(sizeof(dlog_args_) <=                                  \
+                           (DLOG_MAX_ARGS + 1) * sizeof(u32),                 \
+                       "too many DLOG arguments");                            \
+        DLOG_write((id), &dlog_args_[1],                                      \
+                   sizeof(dlog_args_) / sizeof(u32) - 1);                     \
+    } while (0)
+
+// Function prototypes
+void DLOG_write(u16 id, const u32 *args, u32 argc);
+int DLOG_read(DlogRecord *rec);
+int DLOG_format(char *buf, size_t size, const DlogRecord *rec);
+u32 DLOG_dropped(void);
+
+#ifndef DLOG_NO_RTOS
+int DLOG_start(DlogSink sink, UBaseType_t priority);
+#endif
+
+#endif /* DLOG_H_ */
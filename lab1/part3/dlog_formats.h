@@ -0,0 +1,20 @@
+/*
+ * dlog_formats.h
+ *
+ * Messages logged through DLOG() in this lab. Append new entries at the end,
+ * the position is the ID stored in each record, so reordering breaks the
+ * decoding of older dumps.
+ */
+
+#ifndef DLOG_FORMATS_H_
+#define DLOG_FORMATS_H_
+
+#define DLOG_FORMATS(X)                                                       \
+    X(LOG_KYPD_STARTED,                                                       \
+      "Pmod KYPD app started. Press any key on the Keypad.\r\n")              \
+    X(LOG_KEY_PRESSED, "Key Pressed: %c\r\n")                                 \
+    X(LOG_MULTI_KEY, "Error: Multiple keys pressed\r\n")                      \
+    X(LOG_STATUS_CHANGED, "Status changed to: %d\n")                          \
+    X(LOG_BRIGHTNESS, "Brightness: %d/%d\n")
+
+#endif /* DLOG_FORMATS_H_ */
@@ -35,7 +35,9 @@
 #include <xil_cache.h>
 
 // Other miscellaneous libraries
+#include "dlog.h"
 #include "pmodkypd.h"
+#include "ssd_driver.h"
 
 // Part 2 headers
 #include "rgb_led.h"
@@ -51,7 +53,6 @@
 #define DEFAULT_KEYTABLE    "0FED789C456B123A"
 
 // channel (subject to change)
-#define SSD_CHANNEL         1
 #define PSHBTN_CHANNEL      1
 
 // Declaring the devices
@@ -59,8 +60,6 @@ PmodKYPD    KYPDInst;
 
 /*************************** Enter your code here ****************************/
 // TODO: Declare the seven-segment display peripheral here.
-XGpio       SSDInst;
-XGpio       rgbLedInst;
 XGpio       pbInst;
 /*****************************************************************************/
 
@@ -73,16 +72,17 @@ enum PWM_Control {
 #define MIN(a,b) (((a)<(b))?(a):(b))
 #define MAX(a,b) (((a)>(b))?(a):(b))
 
+// GIC instance set up by the FreeRTOS port when the scheduler starts
+extern XScuGic xInterruptController;
+
 // Function prototypes
 void InitializeKeypad();
 static void vKeypadTask( void *pvParameters );
 static void vRgbTask(void *pvParameters);
 static void vButtonsTask(void *pvParameters);
-static void vDisplayTask(void *pvParameters);
-u32 SSD_decode(u8 key_value, u8 cathode);
+static void logSink(const char *buf, size_t len);
 
 // Queue handles
-QueueHandle_t keypad_to_ssd_handle;
 QueueHandle_t pushbutton_to_led_handle;
 
 
@@ -96,24 +96,25 @@ int main(void)
 
 /*************************** Enter your code here ****************************/
     // TODO: Initialize SSD and set the GPIO direction to output.
-    XGpio_Initialize(&SSDInst, SSD_DEVICE_ID);
-    XGpio_SetDataDirection(&SSDInst, SSD_CHANNEL, 0x0); // sets all pins as outputs
+    SSD_begin(SSD_DEVICE_ID);
 
-    // initialize LEDS and set GPIO direction to output
-    XGpio_Initialize(&rgbLedInst, RGB_LED_BASEADDR);
-    XGpio_SetDataDirection(&rgbLedInst, RGB_CHANNEL, 0x0);
+    // initialize the RGB LED, its PWM runs from a timer interrupt
+    RGB_begin(RGB_LED_BASEADDR);
 
     // initialize pushbutton GPIO
     XGpio_Initialize(&pbInst, PSHBTN_DEVICE_ID);
     XGpio_SetDataDirection(&pbInst, PSHBTN_CHANNEL, 0x1);
 
     // queue creation
-    keypad_to_ssd_handle = xQueueCreate(1, sizeof(u8));
     pushbutton_to_led_handle = xQueueCreate(1, sizeof(u32));
 /*****************************************************************************/
 
     xil_printf("Initialization Complete, System Ready!\n");
 
+    // Task messages are formatted and printed by the log task, which runs
+    // when the others are blocked
+    DLOG_start(logSink, tskIDLE_PRIORITY);
+
     xTaskCreate(vKeypadTask,                    /* The function that implements the task. */
                 "main task",                /* Text name for the task, provided to assist debugging only. */
                 configMINIMAL_STACK_SIZE,   /* The stack allocated to the task. */
@@ -135,13 +136,6 @@ int main(void)
             tskIDLE_PRIORITY, 
             NULL);
 
-    xTaskCreate(vDisplayTask,
-        "display task", 
-        configMINIMAL_STACK_SIZE, 
-        NULL, 
-        tskIDLE_PRIORITY, 
-        NULL);
-
     vTaskStartScheduler();
     while(1);
     return 0;
@@ -150,34 +144,41 @@ int main(void)
 
 static void vKeypadTask( void *pvParameters )
 {
-    u8 new_key;
-    u16 keystate;
+    u8 new_key, current_key = 'x', previous_key = 'x';
+    KYPD_Event event;
     XStatus status, previous_status = KYPD_NO_KEY;
-    const TickType_t xDelay = 50;
 
-    xil_printf("Pmod KYPD app started. Press any key on the Keypad.\r\n");
+    // The SSD is refreshed from the TTC interrupt, this task only updates it
+    if (SSD_startRefresh(&xInterruptController) != XST_SUCCESS) {
+        xil_printf("SSD refresh timer setup failed\r\n");
+    }
+    SSD_showChars(previous_key, current_key); // left side, right side
+
+    DLOG(LOG_KYPD_STARTED);
     while (1){
-        // Capture state of the keypad
-        keystate = KYPD_getKeyStates(&KYPDInst);
+        // Block until the debounced keypad reports a press, release or repeat
+        KYPD_waitEvent(&KYPDInst, &event, portMAX_DELAY);
 
         // Determine which single key is pressed, if any
-        // if a key is pressed, store the value of the new key in new_key
-        status = KYPD_getKeyPressed(&KYPDInst, keystate, &new_key);
+        status = KYPD_getKeyPressed(&KYPDInst,
+                                    KYPD_getDebouncedKeyStates(&KYPDInst),
+                                    &new_key);
 
         // Print key detect if a new key is pressed or if status has changed
-        if (status == KYPD_SINGLE_KEY && previous_status == KYPD_NO_KEY){
-            xil_printf("Key Pressed: %c\r\n", (char) new_key);
-            xQueueOverwrite(keypad_to_ssd_handle, &new_key); // put in queue
+        if (event.type == KYPD_EVENT_PRESS && status == KYPD_SINGLE_KEY){
+            DLOG(LOG_KEY_PRESSED, event.key);
+            previous_key = current_key;
+            current_key = event.key;
+            SSD_showChars(previous_key, current_key);
         } else if (status == KYPD_MULTI_KEY && status != previous_status){
-            xil_printf("Error: Multiple keys pressed\r\n");
+            DLOG(LOG_MULTI_KEY);
         }
         
         // display the value of `status` each time it changes
         if (previous_status != status) {
-            xil_printf("Status changed to: %d\n", status); 
+            DLOG(LOG_STATUS_CHANGED, status);
         }
         previous_status = status;
-        vTaskDelay(xDelay);
     }
 }
 
@@ -188,41 +189,6 @@ void InitializeKeypad()
     KYPD_loadKeyTable(&KYPDInst, (u8*) DEFAULT_KEYTABLE);
 }
 
-// This function is hard coded to translate key value codes to their binary representation
-u32 SSD_decode(u8 key_value, u8 cathode)
-{
-    u32 result;
-
-    // key_value represents the code of the pressed key
-    switch(key_value){ // Handles the coding of the 7-seg display
-        case 48: result = 0b00111111; break; // 0
-        case 49: result = 0b00110000; break; // 1
-        case 50: result = 0b01011011; break; // 2
-        case 51: result = 0b01111001; break; // 3
-        case 52: result = 0b01110100; break; // 4
-        case 53: result = 0b01101101; break; // 5
-        case 54: result = 0b01101111; break; // 6
-        case 55: result = 0b00111000; break; // 7
-        case 56: result = 0b01111111; break; // 8
-        case 57: result = 0b01111100; break; // 9
-        case 65: result = 0b01111110; break; // A
-        case 66: result = 0b01100111; break; // B
-        case 67: result = 0b00001111; break; // C
-        case 68: result = 0b01110011; break; // D
-        case 69: result = 0b01001111; break; // E
-        case 70: result = 0b01001110; break; // F
-        default: result = 0b00000000; break; // default case - all seven segments are OFF
-    }
-
-    // cathode handles which display is active (left or right)
-    // by setting the MSB to 1 or 0
-    if(cathode==0){
-            return result;
-    } else {
-            return result | 0b10000000;
-    }
-}
-
 // Based on the button input, convert to a PWM
 // opcode for the LED
 enum PWM_Control LED_decode(u32 input) {
@@ -235,69 +201,53 @@ enum PWM_Control LED_decode(u32 input) {
 
 static void vRgbTask(void *pvParameters)
 {
-    const uint8_t color = RGB_CYAN;
-    const TickType_t xPeriod = 20;
-    TickType_t xTimeOn = xPeriod;
-    TickType_t xTimeOff = 0;
     u32 input_value;
-    enum PWM_Control ctrl;
+    u8 brightness;
 
-    while (1) {
-        if (pdTRUE == xQueueReceive(pushbutton_to_led_handle, &input_value, 0)) {
-            ctrl = LED_decode(input_value);
-            switch (ctrl) {
-            case TURN_DOWN:
-                xTimeOff = MIN(xPeriod, xTimeOff + 1);
-                xTimeOn = xPeriod - xTimeOff;
-                xil_printf("Time On: %d --- Time Off: %d\n", xTimeOn, xTimeOff);
-                break;
-            case TURN_UP:
-                xTimeOn = MIN(xPeriod, xTimeOn + 1);
-                xTimeOff = xPeriod - xTimeOn;
-                xil_printf("Time On: %d --- Time Off: %d\n", xTimeOn, xTimeOff);
-                break;
-            case UNKNOWN:
-              break;
-            }
-        }
+    if (RGB_startPwm(&xInterruptController) != XST_SUCCESS) {
+        xil_printf("RGB PWM timer setup failed\r\n");
+    }
+    RGB_setBrightness(RGB_PWM_MAX);
+    RGB_setColor(RGB_CYAN);
 
-        if (xTimeOn != 0) {
-            // ensure it turns off fully :)
-            XGpio_DiscreteWrite(&rgbLedInst, RGB_CHANNEL, color);
-            vTaskDelay(xTimeOn);
+    while (1) {
+        // The PWM runs on its own, this task only wakes up while a button is
+        // held, once per poll so holding one keeps stepping the brightness
+        xQueueReceive(pushbutton_to_led_handle, &input_value, portMAX_DELAY);
+        switch (LED_decode(input_value)) {
+        case TURN_DOWN:
+            brightness = RGB_stepBrightness(-RGB_BRIGHTNESS_STEP);
+            DLOG(LOG_BRIGHTNESS, brightness, RGB_PWM_MAX);
+            break;
+        case TURN_UP:
+            brightness = RGB_stepBrightness(RGB_BRIGHTNESS_STEP);
+            DLOG(LOG_BRIGHTNESS, brightness, RGB_PWM_MAX);
+            break;
+        case UNKNOWN:
+          break;
         }
-        XGpio_DiscreteWrite(&rgbLedInst, RGB_CHANNEL, 0);
-        vTaskDelay(xTimeOff);
     }
 }
 
 static void vButtonsTask(void *pvParameters) {
     const TickType_t xDelay = 50;
     u32 input_value;
+    u32 last_value = 0;
     while (1) {
         input_value = XGpio_DiscreteRead(&pbInst, PSHBTN_CHANNEL);
-        xQueueOverwrite(pushbutton_to_led_handle, &input_value);
+        // Nothing to send while all the buttons stay released
+        if (input_value != 0 || input_value != last_value) {
+            xQueueOverwrite(pushbutton_to_led_handle, &input_value);
+        }
+        last_value = input_value;
         vTaskDelay(xDelay);
     }
 }
 
-static void vDisplayTask(void *pvParameters) {
-    const TickType_t xDelay = 12; // portticks
-    u8 new_key, current_key = 'x', previous_key = 'x';
-    u32 ssd_value=0;
-
-    while (1) {
-        if (pdTRUE == xQueueReceive(keypad_to_ssd_handle, &new_key, 0)) {
-            previous_key = current_key;
-            current_key = new_key;
-        }
-        
-        ssd_value = SSD_decode(current_key, (u8) 1); // right side, cat = 1
-        XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, ssd_value);
-        vTaskDelay(xDelay);
-
-        ssd_value = SSD_decode(previous_key, (u8) 0); // left side, cat = 0
-        XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, ssd_value);
-        vTaskDelay(xDelay);
+// Runs in the log task, so waiting on the UART here holds up nothing else
+static void logSink(const char *buf, size_t len)
+{
+    while (len-- > 0) {
+        outbyte(*buf++);
     }
 }
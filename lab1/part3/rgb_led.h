@@ -1,6 +1,12 @@
 #ifndef RGB_LED_H
 #define RGB_LED_H
 
+#include "xil_io.h"
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xparameters.h"
+#include "xscugic.h"
+
 /* ================= RGB LED Colors ================= */
 #define RGB_OFF     0b000
 #define RGB_RED     0b100
@@ -15,5 +21,27 @@
 #define RGB_LED_BASEADDR XPAR_GPIO_LEDS_BASEADDR
 #define RGB_CHANNEL   2
 
+#define RGB_GPIO_DATA_OFFSET 0x008 // AXI GPIO channel 2 (PG144)
+#define RGB_GPIO_TRI_OFFSET  0x00C
+
+/* ================= PWM Engine ================= */
+// Software PWM from the TTC0 counter 1 interval interrupt. Each tick
+// advances an 8-bit phase and compares it against the duty of each channel,
+// so one PWM period is 256 ticks (100 Hz at RGB_PWM_TICK_HZ).
+#define RGB_TIMER_BASEADDR XPAR_XTTCPS_1_BASEADDR
+#define RGB_TIMER_IRQ_ID   XPS_TTC0_1_INT_ID
+#define RGB_PWM_TICK_HZ    25600
+
+#define RGB_PWM_MAX        255 // Duty for a channel that is always on
+#define RGB_BRIGHTNESS_STEP 16 // Brightness change per button press
+
+void RGB_begin(u32 GpioBaseAddress);
+int RGB_startPwm(XScuGic *IntcInstancePtr);
+void RGB_stopPwm(void);
+void RGB_setDuty(u8 red, u8 green, u8 blue);
+void RGB_setColor(u8 color);
+void RGB_setBrightness(u8 brightness);
+u8 RGB_stepBrightness(int step);
+void RGB_interruptHandler(void *CallBackRef);
 
 #endif /* RGB_LED_H */
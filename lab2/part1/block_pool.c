@@ -0,0 +1,67 @@
+/*
+ * block_pool.c
+ */
+
+#include "block_pool.h"
+
+#include "task.h"
+
+static PoolHeader *headerOf(void *obj) {
+    return (PoolHeader *)((u8 *)obj - POOL_ALIGN(sizeof(PoolHeader)));
+}
+
+// storage needs POOL_STORAGE_LEN(objSize, count) bytes, 8-byte aligned
+int POOL_init(BlockPool *pool, void *storage, size_t objSize, size_t count) {
+    PoolHeader *header;
+    size_t i;
+
+    pool->blockSize = POOL_BLOCK_SIZE(objSize);
+    pool->count     = count;
+    pool->freeList  = xQueueCreate(count, sizeof(PoolHeader *));
+    if (pool->freeList == NULL) return XST_FAILURE;
+
+    for (i = 0; i < count; i++) {
+        header       = (PoolHeader *)((u8 *)storage + i * pool->blockSize);
+        header->pool = pool;
+        header->refs = 0;
+        xQueueSend(pool->freeList, &header, 0);
+    }
+
+    return XST_SUCCESS;
+}
+
+// Returns NULL if no block was freed within timeout
+void *POOL_alloc(BlockPool *pool, TickType_t timeout) {
+    PoolHeader *header;
+
+    if (xQueueReceive(pool->freeList, &header, timeout) != pdTRUE) {
+        return NULL;
+    }
+
+    header->refs = 1;
+    return (u8 *)header + POOL_ALIGN(sizeof(PoolHeader));
+}
+
+void POOL_retain(void *obj) {
+    PoolHeader *header = headerOf(obj);
+
+    taskENTER_CRITICAL();
+    ++header->refs;
+    taskEXIT_CRITICAL();
+}
+
+void POOL_release(void *obj) {
+    PoolHeader *header = headerOf(obj);
+    u32 refs;
+
+    taskENTER_CRITICAL();
+    refs = --header->refs;
+    taskEXIT_CRITICAL();
+
+    // The free list has room for every block, this never waits
+    if (refs == 0) xQueueSend(header->pool->freeList, &header, 0);
+}
+
+UBaseType_t POOL_available(const BlockPool *pool) {
+    return uxQueueMessagesWaiting(pool->freeList);
+}
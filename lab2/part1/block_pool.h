@@ -0,0 +1,56 @@
+/*
+ * block_pool.h
+ *
+ * Fixed-block allocator for objects that are handed between tasks through
+ * queues. The queues carry pointers, the objects stay where they were
+ * allocated. Every block starts with a reference count: POOL_alloc() returns
+ * it at 1, handing the pointer to another task hands over that reference,
+ * and a task that keeps using an object after passing it on takes its own
+ * with POOL_retain(). The last POOL_release() puts the block back.
+ *
+ * The free list is a FreeRTOS queue of block pointers, so POOL_alloc() can
+ * block until another task releases a block.
+ */
+
+#ifndef BLOCK_POOL_H_
+#define BLOCK_POOL_H_
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "queue.h"
+
+#include <stddef.h>
+
+// Macros
+#define POOL_ALIGN(n) (((n) + 7U) & ~(size_t)7U)
+
+// Bytes of storage for count objects of objSize bytes
+#define POOL_BLOCK_SIZE(objSize)                                              \
+    (POOL_ALIGN(sizeof(PoolHeader)) + POOL_ALIGN(objSize))
+#define POOL_STORAGE_LEN(objSize, count) (POOL_BLOCK_SIZE(objSize) * (count))
+
+typedef struct BlockPool BlockPool;
+
+// Precedes every object in the storage
+typedef struct {
+    BlockPool *pool;
+    volatile u32 refs; // 0 while the block is on the free list
+} PoolHeader;
+
+struct BlockPool {
+    QueueHandle_t freeList; // PoolHeader pointers
+    size_t blockSize;
+    size_t count;
+};
+
+// Function prototypes
+int POOL_init(BlockPool *pool, void *storage, size_t objSize, size_t count);
+void *POOL_alloc(BlockPool *pool, TickType_t timeout);
+void POOL_retain(void *obj);
+void POOL_release(void *obj);
+UBaseType_t POOL_available(const BlockPool *pool);
+
+#endif /* BLOCK_POOL_H_ */
@@ -0,0 +1,100 @@
+/*
+ * hmac_sha256.c
+ */
+
+#include <string.h>
+
+#include "hmac_sha256.h"
+
+#define IPAD 0x36
+#define OPAD 0x5c
+
+// Clears memory the compiler may not drop as a dead store
+static void wipe(void *p, size_t len)
+{
+	volatile BYTE *v = p;
+
+	while (len--)
+		*v++ = 0;
+}
+
+// Keys longer than a block are replaced by their hash, as RFC 2104 says
+void hmacSha256SetKey(HMAC_SHA256_KEY *key, const BYTE k[], size_t len)
+{
+	BYTE block[64];
+	SHA256_CTX ctx;
+	int i;
+
+	memset(block, 0, sizeof(block));
+	if (len > sizeof(block)){
+		sha256Init(&ctx);
+		sha256Update(&ctx, k, len);
+		sha256Final(&ctx, block);
+	} else {
+		memcpy(block, k, len);
+	}
+
+	for (i = 0; i < 64; ++i)
+		block[i] ^= IPAD;
+	sha256Init(&ctx);
+	sha256Update(&ctx, block, sizeof(block));
+	memcpy(key->inner, ctx.state, sizeof(key->inner));
+
+	for (i = 0; i < 64; ++i)
+		block[i] ^= IPAD ^ OPAD;
+	sha256Init(&ctx);
+	sha256Update(&ctx, block, sizeof(block));
+	memcpy(key->outer, ctx.state, sizeof(key->outer));
+
+	wipe(block, sizeof(block));
+	wipe(&ctx, sizeof(ctx));
+}
+
+void hmacSha256ClearKey(HMAC_SHA256_KEY *key)
+{
+	wipe(key, sizeof(*key));
+}
+
+// Starts from the cached state, as if the ipad block had just been hashed
+static void resume(SHA256_CTX *ctx, const WORD state[8])
+{
+	memcpy(ctx->state, state, sizeof(ctx->state));
+	ctx->datalen = 0;
+	ctx->bitlen = 512;
+}
+
+void hmacSha256Init(HMAC_SHA256_CTX *ctx, const HMAC_SHA256_KEY *key)
+{
+	resume(&ctx->inner, key->inner);
+	ctx->key = key;
+}
+
+void hmacSha256Update(HMAC_SHA256_CTX *ctx, const BYTE data[], size_t len)
+{
+	sha256Update(&ctx->inner, data, len);
+}
+
+void hmacSha256Final(HMAC_SHA256_CTX *ctx, BYTE mac[HMAC_SHA256_LEN])
+{
+	SHA256_CTX outer;
+	BYTE inner_hash[SHA256_BLOCK_SIZE];
+
+	sha256Final(&ctx->inner, inner_hash);
+
+	// 32 bytes after the opad block, padding included, is one compression
+	resume(&outer, ctx->key->outer);
+	sha256Update(&outer, inner_hash, sizeof(inner_hash));
+	sha256Final(&outer, mac);
+
+	wipe(inner_hash, sizeof(inner_hash));
+}
+
+void hmacSha256(const HMAC_SHA256_KEY *key, const BYTE data[], size_t len,
+                BYTE mac[HMAC_SHA256_LEN])
+{
+	HMAC_SHA256_CTX ctx;
+
+	hmacSha256Init(&ctx, key);
+	hmacSha256Update(&ctx, data, len);
+	hmacSha256Final(&ctx, mac);
+}
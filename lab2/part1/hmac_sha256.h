@@ -0,0 +1,43 @@
+/*
+ * hmac_sha256.h
+ *
+ * HMAC-SHA256 (RFC 2104) on top of sha256.h. hmacSha256SetKey() hashes the
+ * key XOR ipad and key XOR opad blocks once and keeps the two states, so
+ * each MAC under that key costs its message blocks plus one compression for
+ * the outer hash, not two more for the padded key.
+ *
+ * Keep one HMAC_SHA256_KEY per key in use. It holds key material, clear it
+ * with hmacSha256ClearKey() when the key is retired.
+ */
+
+#ifndef HMAC_SHA256_H
+#define HMAC_SHA256_H
+
+#include <stddef.h>
+
+#include "sha256.h"
+
+#define HMAC_SHA256_LEN 32
+
+typedef struct {
+	WORD inner[8]; // State after the key XOR ipad block
+	WORD outer[8]; // State after the key XOR opad block
+} HMAC_SHA256_KEY;
+
+typedef struct {
+	SHA256_CTX inner;
+	const HMAC_SHA256_KEY *key;
+} HMAC_SHA256_CTX;
+
+void hmacSha256SetKey(HMAC_SHA256_KEY *key, const BYTE k[], size_t len);
+void hmacSha256ClearKey(HMAC_SHA256_KEY *key);
+
+void hmacSha256Init(HMAC_SHA256_CTX *ctx, const HMAC_SHA256_KEY *key);
+void hmacSha256Update(HMAC_SHA256_CTX *ctx, const BYTE data[], size_t len);
+void hmacSha256Final(HMAC_SHA256_CTX *ctx, BYTE mac[HMAC_SHA256_LEN]);
+
+// One-shot MAC of data under key
+void hmacSha256(const HMAC_SHA256_KEY *key, const BYTE data[], size_t len,
+                BYTE mac[HMAC_SHA256_LEN]);
+
+#endif   // HMAC_SHA256_H
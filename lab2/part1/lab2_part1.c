@@ -17,11 +17,16 @@
  */
 
 #include "FreeRTOS.h"
+#include "block_pool.h"
 #include "queue.h"
 #include "sha256.h"
+#include "sha256_x4.h"
 #include "task.h"
+#include "uart_frame.h"
+#include "uart_stream.h"
 
 #include "xparameters.h"
+#include "xscugic.h"
 #include "xuartps.h"
 
 #include <portmacro.h>
@@ -35,17 +40,12 @@
 // ======================================================
 // Configuration
 // ======================================================
-#define UART_BASEADDR XPAR_UART1_BASEADDR
-#define RX_QUEUE_LEN  512
-#define CMD_QUEUE_LEN 16
-#define TX_QUEUE_LEN  (512 * 2) // had to be increased to work
+#define REQUEST_POOL_LEN 8 // Requests in flight, the queues hold pointers
 
-#define INPUT_TEXT_LEN 512 // 256
+#define INPUT_TEXT_LEN FRAME_MAX_PAYLOAD // Binary mode, text input is streamed
 #define HASH_HEX_LEN   64  // SHA-256 hex chars
 #define HASH_LEN       32
 
-#define POLL_DELAY_MS 10 // changed from 1000
-
 // ======================================================
 // Types
 // ======================================================
@@ -55,53 +55,70 @@ typedef enum {
     CMD_VERIFY = '2',
 } command_type_t;
 
-typedef struct {
-    command_type_t type;
-    char input_text[INPUT_TEXT_LEN];
-    char expected_hash[HASH_HEX_LEN + 1]; // used only for VERIFY
-} crypto_request_t;
+// Where Result_Task delivers the answer
+typedef enum {
+    REPLY_TEXT,  // Printed for the menu
+    REPLY_FRAME, // Sent as the response frame with the request's id
+} reply_type_t;
 
+// Binary throughout, the hex is only made when a result is printed
 typedef struct {
-    command_type_t type;
-    char calculated_hash[HASH_HEX_LEN + 1];
+    BYTE hash[HASH_LEN];
     u8 match; // 0 = false, 1 = true
 } crypto_result_t;
 
+// Allocated from request_pool by the CLI, passed by pointer through q_cmd
+// and q_result, and released by Result_Task once the answer is out.
+// CMD_NONE requests are passed through untouched. binary_mode() queues one
+// behind the hashes when it leaves, so its reply goes out after theirs.
+typedef struct {
+    command_type_t type;
+    reply_type_t reply;
+    u16 id; // Text requests are numbered by the CLI, frames keep their id
+    char input_text[INPUT_TEXT_LEN];
+    size_t input_len;                     // binary mode input may hold zeros
+    u8 streamed; // Text input, hashed by the CLI as it arrived, its digest
+                 // is already in result.hash and input_text is unused
+    BYTE expected_hash[HASH_LEN];         // used only for VERIFY
+    crypto_result_t result;               // Filled in by Crypto_Task
+} crypto_request_t;
+
 // ======================================================
 // FreeRTOS objects
 // ======================================================
-static QueueHandle_t q_rx_byte = NULL; // uint8_t
-static QueueHandle_t q_cmd     = NULL; // crypto_request_t
-static QueueHandle_t q_result  = NULL; // crypto_result_t
-static QueueHandle_t q_tx      = NULL; // char
+static QueueHandle_t q_cmd    = NULL; // crypto_request_t *
+static QueueHandle_t q_result = NULL; // crypto_request_t *, result filled in
 
-// ======================================================
-// UART instance
-// ======================================================
-static XUartPs UartPs;
+static BlockPool request_pool;
+static u8 request_storage[POOL_STORAGE_LEN(
+    sizeof(crypto_request_t), REQUEST_POOL_LEN)] __attribute__((aligned(8)));
+
+// GIC instance set up by the FreeRTOS port when the scheduler starts
+extern XScuGic xInterruptController;
 
 // ======================================================
 // Task prototypes
 // ======================================================
-static void UART_RX_Task(void *pvParameters);
 static void CLI_Task(void *pvParameters);
 static void Crypto_Task(void *pvParameters);
-static void UART_TX_Task(void *pvParameters);
+static void Result_Task(void *pvParameters);
+static void binary_mode(void);
 
 // ======================================================
 // Crypto helpers
 // ======================================================
-void hash_to_string(BYTE *hash, char *hashString);
-void sha256_string(const char *input, BYTE output[32]);
+void hash_to_string(const BYTE *hash, char *hash_string);
+int string_to_hash(const char *hash_string, BYTE *hash);
+static u8 hash_equal(const BYTE *a, const BYTE *b);
+void sha256_string(const char *input, size_t len, BYTE output[32]);
+static void sha256_batch(crypto_request_t *const batch[], int count);
 
 // ======================================================
 // UART helpers
 // ======================================================
 uint8_t receive_byte(uint8_t *out_byte);
 void receive_string(char *buf, size_t buf_len);
-static void uart_init(void);
-static int uart_poll_rx(uint8_t *b);
-static void uart_tx_byte(uint8_t b);
+size_t receive_hashed(BYTE output[32]);
 
 // ======================================================
 // Custom UART functions
@@ -109,6 +126,7 @@ static void uart_tx_byte(uint8_t b);
 void print_string(const char *str);
 void print_new_lines(int count);
 void flush_uart(void);
+static void print_uart_link(void);
 
 const char *init_message = "A hash function is a mathematical algorithm that "
                            "takes an input (or \"message\")\n"
@@ -126,32 +144,35 @@ const char *init_message = "A hash function is a mathematical algorithm that "
 
 int main(void) {
 
-    uart_init();
-
-    xTaskCreate(UART_RX_Task, "UART_RX", 1024, NULL, 3, NULL);
-
-    xTaskCreate(UART_TX_Task, "UART_TX", 1024, NULL, 3, NULL);
+    if (uart_init() != XST_SUCCESS) {
+        while (1) {
+        }
+    }
 
     xTaskCreate(CLI_Task, "CLI", 2048, (void *)init_message, 2, NULL);
 
     xTaskCreate(Crypto_Task, "CRYPTO", 2048, NULL, 2, NULL);
 
-    q_rx_byte = xQueueCreate(RX_QUEUE_LEN, sizeof(uint8_t));
-    q_tx      = xQueueCreate(TX_QUEUE_LEN, sizeof(uint8_t));
-    q_cmd     = xQueueCreate(CMD_QUEUE_LEN, sizeof(crypto_request_t));
-    q_result  = xQueueCreate(CMD_QUEUE_LEN, sizeof(crypto_result_t));
+    xTaskCreate(Result_Task, "RESULT", 2048, NULL, 2, NULL);
+
+    q_cmd    = xQueueCreate(REQUEST_POOL_LEN, sizeof(crypto_request_t *));
+    q_result = xQueueCreate(REQUEST_POOL_LEN, sizeof(crypto_request_t *));
+
+    if (POOL_init(&request_pool, request_storage, sizeof(crypto_request_t),
+                  REQUEST_POOL_LEN) != XST_SUCCESS) {
+        while (1) {
+        }
+    }
 
-    configASSERT(UART_RX_Task);
-    configASSERT(UART_TX_Task);
     configASSERT(CLI_Task);
     configASSERT(Crypto_Task);
-    configASSERT(q_rx_byte);
+    configASSERT(Result_Task);
     configASSERT(q_cmd);
     configASSERT(q_result);
-    configASSERT(q_tx);
 
     print_new_lines(50);
     print_string("Initialization complete\nSTARTING APP\n");
+    print_uart_link();
 
     vTaskStartScheduler();
 
@@ -159,50 +180,24 @@ int main(void) {
     }
 }
 
-// ======================================================
-// UART RX Task
-// ======================================================
-
-static void UART_RX_Task(void *pvParameters) {
-    (void)pvParameters;
-
-    uint8_t byte;
-
-    for (;;) {
-        if (uart_poll_rx(&byte)) {
-            xQueueSend(q_rx_byte, &byte, 0);
-        }
-        vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
-    }
-}
-
-// ======================================================
-// UART TX Task
-// ======================================================
-
-static void UART_TX_Task(void *pvParameters) {
-    (void)pvParameters;
-
-    char c;
-
-    for (;;) {
-        if (xQueueReceive(q_tx, &c, 0) == pdTRUE) {
-            uart_tx_byte((uint8_t)c);
-        }
-        vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
-    }
-}
-
 // ======================================================
 // CLI Task
 // ======================================================
 
+// Queues each request and goes straight back to the menu, Result_Task prints
+// the answer when it is ready. The next string can be typed while the last
+// one is still hashing.
 static void CLI_Task(void *pvParameters) {
     command_type_t op = CMD_NONE;
-    crypto_request_t req;
-    crypto_result_t res;
-
-    uint8_t dummy;
+    crypto_request_t *req;
+    u16 next_id = 0;
+    char line[64];
+    char hex[HASH_HEX_LEN + 2]; // One more, so a longer entry is caught
+
+    // Received bytes are queued by the UART interrupt from here on
+    if (uart_start(&xInterruptController) != XST_SUCCESS) {
+        print_string("UART interrupt setup failed\n");
+    }
 
     print_string((const char *)pvParameters);
 
@@ -214,59 +209,57 @@ static void CLI_Task(void *pvParameters) {
 
         receive_byte((uint8_t *)&op);
 
+        // A frame delimiter instead of an option starts a binary session
+        if (op == FRAME_DELIMITER) {
+            binary_mode();
+            continue;
+        }
+
         print_string("\n*******************************************\n");
 
+        if (op != CMD_HASH && op != CMD_VERIFY) {
+            print_string("\nOption not recognized\n");
+            continue;
+        }
+
+        // Waits for a block while REQUEST_POOL_LEN requests are in flight
+        req       = POOL_alloc(&request_pool, portMAX_DELAY);
+        req->type = op;
+
+        // Any length, the hash is ready when the '\r' arrives
+        req->streamed = 1;
+
         switch (op) {
         case CMD_HASH:
-            req.type = CMD_HASH;
             print_string("\nEnter string to calculate hash: ");
-            receive_string(req.input_text, sizeof(req.input_text));
-            xQueueSend(q_cmd, &req, 0);
-            /* Polling queue for result */
-            while (xQueueReceive(q_result, &res, 0) != pdTRUE) {
-                vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
-            }
-            print_string("\nCalculated hash: ");
-            print_string(res.calculated_hash);
-            print_string("\n");
+            req->input_len = receive_hashed(req->result.hash);
             break;
 
-        case CMD_VERIFY:
-            req.type = CMD_VERIFY;
+        default:
             print_string("\nEnter string to verify: ");
-            receive_string(req.input_text, sizeof(req.input_text));
+            req->input_len = receive_hashed(req->result.hash);
 
             print_string("\nEnter the precomputed hash: ");
-            receive_string(req.expected_hash, sizeof(req.expected_hash));
-
-            xQueueSend(q_cmd, &req, 0);
-
-            /* Wait (polling) for result */
-            while (xQueueReceive(q_result, &res, 0) != pdTRUE) {
-                vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
-            }
-
-            print_string("\nCalculated hash: ");
-            print_string(res.calculated_hash);
-            print_string("\nExpected hash: ");
-            print_string(req.expected_hash);
-
-            if (res.match) {
-                print_string("\nHashes are the same!\n");
-            } else {
-                print_string("\nHashes are different\n");
-            }
+            receive_string(hex, sizeof(hex));
             break;
+        }
 
-        default: print_string("\nOption not recognized\n"); break;
+        // Parsed once here, the crypto task compares bytes
+        if (op == CMD_VERIFY &&
+            string_to_hash(hex, req->expected_hash) != XST_SUCCESS) {
+            print_string("\nThe hash must be 64 hex digits\n");
+            POOL_release(req);
+            continue;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        print_string("\nPress any key to continue.");
-        receive_byte(&dummy);
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        flush_uart();
-        print_new_lines(50);
+        req->reply = REPLY_TEXT;
+        req->id    = next_id++;
+        snprintf(line, sizeof(line), "\nRequest #%u queued\n",
+                 (unsigned)req->id);
+
+        // Printed first, the result can be ready before xQueueSend returns
+        print_string(line);
+        xQueueSend(q_cmd, &req, portMAX_DELAY);
     }
 }
 
@@ -274,43 +267,217 @@ static void CLI_Task(void *pvParameters) {
 // Crypto Task
 // ======================================================
 
+// Takes whatever is already queued behind the first request, up to one per
+// SHA-256 lane, and hashes the batch together. Results keep the queue order.
 static void Crypto_Task(void *pvParameters) {
     (void)pvParameters;
 
-    crypto_request_t req;
-    crypto_result_t res;
+    crypto_request_t *batch[SHA256_X4_LANES];
+    crypto_result_t *res;
+    int count, i;
+
+#if defined(__arm__) && !defined(SHA256_X4_SCALAR)
+    // sha256_x4 uses NEON, whose registers are the FPU registers, so save
+    // them on a task switch. No other task may call sha256_x4_*().
+    portTASK_USES_FLOATING_POINT();
+#endif
+
+    for (;;) {
+        xQueueReceive(q_cmd, &batch[0], portMAX_DELAY);
+        for (count = 1; count < SHA256_X4_LANES; count++) {
+            if (xQueueReceive(q_cmd, &batch[count], 0) != pdTRUE) break;
+        }
+
+        sha256_batch(batch, count);
+
+        for (i = 0; i < count; i++) {
+            res        = &batch[i]->result;
+            res->match = 0;
+
+            if (batch[i]->type == CMD_VERIFY) {
+                res->match = hash_equal(res->hash, batch[i]->expected_hash);
+            }
+
+            xQueueSend(q_result, &batch[i], portMAX_DELAY);
+        }
+    }
+}
+
+// ======================================================
+// Result Task
+// ======================================================
+
+// Delivers results in the order they were requested and releases the
+// requests. A text result is built into one buffer so it goes out in a
+// single write, even when the menu is being printed at the same time.
+static void Result_Task(void *pvParameters) {
+    (void)pvParameters;
 
-    unsigned char hash[HASH_LEN];
+    crypto_request_t *req;
+    crypto_result_t *res;
+    char text[256];
+    char calculated[HASH_HEX_LEN + 1], expected[HASH_HEX_LEN + 1];
+    u8 reply[1 + HASH_LEN];
 
     for (;;) {
-        if (xQueueReceive(q_cmd, &req, 0) == pdTRUE) {
-            sha256_string(req.input_text, hash);
-            hash_to_string(hash, res.calculated_hash);
+        xQueueReceive(q_result, &req, portMAX_DELAY);
+        res = &req->result;
+
+        if (req->reply == REPLY_FRAME) {
+            switch (req->type) {
+            case CMD_HASH:
+                FRAME_send(FRAME_CMD_HASH | FRAME_RESPONSE, FRAME_OK, req->id,
+                           res->hash, HASH_LEN);
+                break;
 
-            res.type  = req.type;
-            res.match = 0;
+            case CMD_VERIFY:
+                reply[0] = res->match;
+                memcpy(&reply[1], res->hash, HASH_LEN);
+                FRAME_send(FRAME_CMD_VERIFY | FRAME_RESPONSE, FRAME_OK,
+                           req->id, reply, sizeof(reply));
+                break;
 
-            if (req.type == CMD_VERIFY) {
-                if (strcmp(res.calculated_hash, req.expected_hash) == 0) {
-                    res.match = 1;
-                }
+            default:
+                FRAME_send(FRAME_CMD_TEXT | FRAME_RESPONSE, FRAME_OK, req->id,
+                           NULL, 0);
+                break;
             }
+        } else if (req->type == CMD_VERIFY) {
+            hash_to_string(res->hash, calculated);
+            hash_to_string(req->expected_hash, expected);
+            snprintf(text, sizeof(text),
+                     "\n[#%u] Calculated hash: %s\n[#%u] Expected hash: %s\n"
+                     "[#%u] %s\n",
+                     (unsigned)req->id, calculated, (unsigned)req->id,
+                     expected, (unsigned)req->id,
+                     res->match ? "Hashes are the same!"
+                                : "Hashes are different");
+            print_string(text);
+        } else {
+            hash_to_string(res->hash, calculated);
+            snprintf(text, sizeof(text), "\n[#%u] Calculated hash: %s\n",
+                     (unsigned)req->id, calculated);
+            print_string(text);
+        }
+
+        POOL_release(req);
+    }
+}
+
+// ======================================================
+// Binary mode
+// ======================================================
+
+// Serves framed requests until FRAME_CMD_TEXT. Hashes are queued and
+// answered by Result_Task, so reading the next request overlaps with hashing
+// the last one. The host matches the answers by id.
+static void binary_mode(void) {
+    static FramePacket pkt;
+    crypto_request_t *req;
+
+    // Frames can hold the XON/XOFF bytes, the host paces itself instead
+    uart_set_xonxoff(0);
+    FRAME_reset();
 
-            xQueueSend(q_result, &res, 0);
+    for (;;) {
+        if (FRAME_receive(&pkt) != XST_SUCCESS) {
+            FRAME_send(FRAME_RESPONSE, FRAME_ERR_CORRUPT, FRAME_ID_UNKNOWN,
+                       NULL, 0);
+            continue;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
+        switch (pkt.cmd) {
+        case FRAME_CMD_PING:
+            FRAME_send(pkt.cmd | FRAME_RESPONSE, FRAME_OK, pkt.id, pkt.payload,
+                       pkt.len);
+            break;
+
+        case FRAME_CMD_TEXT:
+            // Answered behind the hashes still in flight
+            req        = POOL_alloc(&request_pool, portMAX_DELAY);
+            req->type     = CMD_NONE;
+            req->reply    = REPLY_FRAME;
+            req->id       = pkt.id;
+            req->streamed = 0;
+            xQueueSend(q_cmd, &req, portMAX_DELAY);
+            uart_set_xonxoff(1);
+            return;
+
+        case FRAME_CMD_HASH:
+            req            = POOL_alloc(&request_pool, portMAX_DELAY);
+            req->type      = CMD_HASH;
+            req->reply     = REPLY_FRAME;
+            req->id        = pkt.id;
+            req->streamed  = 0;
+            req->input_len = pkt.len;
+            memcpy(req->input_text, pkt.payload, pkt.len);
+
+            xQueueSend(q_cmd, &req, portMAX_DELAY);
+            break;
+
+        case FRAME_CMD_VERIFY:
+            // Expected hash first, then the data
+            if (pkt.len < HASH_LEN) {
+                FRAME_send(pkt.cmd | FRAME_RESPONSE, FRAME_ERR_LEN, pkt.id,
+                           NULL, 0);
+                break;
+            }
+
+            req            = POOL_alloc(&request_pool, portMAX_DELAY);
+            req->type      = CMD_VERIFY;
+            req->reply     = REPLY_FRAME;
+            req->id        = pkt.id;
+            req->streamed  = 0;
+            req->input_len = pkt.len - HASH_LEN;
+            memcpy(req->expected_hash, pkt.payload, HASH_LEN);
+            memcpy(req->input_text, &pkt.payload[HASH_LEN], req->input_len);
+
+            xQueueSend(q_cmd, &req, portMAX_DELAY);
+            break;
+
+        default:
+            FRAME_send(pkt.cmd | FRAME_RESPONSE, FRAME_ERR_CMD, pkt.id, NULL,
+                       0);
+            break;
+        }
     }
 }
 
 uint8_t receive_byte(uint8_t *out_byte) {
-    while (1) {
-        if (xQueueReceive(q_rx_byte, out_byte, 0) != pdTRUE) {
-            vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
-        } else {
-            return *out_byte;
+    while (uart_read(out_byte, 1, portMAX_DELAY) == 0) {
+    }
+    return *out_byte;
+}
+
+// Hashes input up to '\r' in whatever chunks the UART delivers, so a string
+// of any length takes constant memory. Only the bytes through the '\r' are
+// consumed, the rest stay in the UART read-ahead for the next prompt or for
+// binary mode. Returns the number of bytes hashed.
+size_t receive_hashed(BYTE output[32]) {
+    SHA256_CTX ctx;
+    const u8 *data;
+    size_t total = 0, avail, end;
+
+    sha256Init(&ctx);
+
+    for (;;) {
+        avail = uart_peek(&data, portMAX_DELAY);
+
+        for (end = 0; end < avail && data[end] != '\r'; end++) {
         }
+
+        sha256Update(&ctx, data, end);
+        total += end;
+
+        if (end < avail) {
+            uart_consume(end + 1); // Through the '\r'
+            break;
+        }
+        uart_consume(avail);
     }
+
+    sha256Final(&ctx, output);
+    return total;
 }
 
 void receive_string(char *buf, size_t buf_len) {
@@ -336,21 +503,31 @@ void receive_string(char *buf, size_t buf_len) {
         }
 
         buf[idx++] = recvd;
-        vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
     }
 }
 
-void flush_uart(void) {
-    uint8_t dummy;
-    while (xQueueReceive(q_rx_byte, &dummy, 0) == pdTRUE)
-        ;
+void flush_uart(void) { uart_flush_rx(); }
+
+// Reports the baud divisor error and the line error counters
+static void print_uart_link(void) {
+    char line[128];
+
+    UART_formatBaud(line, sizeof(line), &uart_baud);
+    print_string(line);
+
+    snprintf(line, sizeof(line),
+             "Overruns %lu, framing %lu, parity %lu, dropped %lu, XOFF %lu\n",
+             (unsigned long)uart_errors.overrun,
+             (unsigned long)uart_errors.framing,
+             (unsigned long)uart_errors.parity,
+             (unsigned long)uart_rx_dropped,
+             (unsigned long)uart_flow.xoffCount);
+    print_string(line);
 }
 
 void print_string(const char *str) {
     if (str == NULL) return;
-    for (; *str != '\0'; ++str) {
-        xQueueSend(q_tx, str, 0);
-    }
+    uart_write(str, strlen(str));
 }
 
 void print_new_lines(int count) {
@@ -359,49 +536,95 @@ void print_new_lines(int count) {
     }
 }
 
-void hash_to_string(BYTE *hash, char *hash_string) {
+void hash_to_string(const BYTE *hash, char *hash_string) {
+    static const char hex_digits[] = "0123456789ABCDEF";
+
     for (int i = 0; i < HASH_LEN; i++) {
-        sprintf(&hash_string[i * 2], "%02X", hash[i]);
+        hash_string[i * 2]     = hex_digits[hash[i] >> 4];
+        hash_string[i * 2 + 1] = hex_digits[hash[i] & 0x0F];
     }
 
     hash_string[HASH_LEN * 2] = '\0'; // Null terminate the string
 }
 
-void sha256_string(const char *input, BYTE output[32]) {
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Exactly HASH_HEX_LEN digits, either case
+int string_to_hash(const char *hash_string, BYTE *hash) {
+    int hi, lo;
+
+    if (strlen(hash_string) != HASH_HEX_LEN) return XST_FAILURE;
+
+    for (int i = 0; i < HASH_LEN; i++) {
+        hi = hex_value(hash_string[i * 2]);
+        lo = hex_value(hash_string[i * 2 + 1]);
+        if (hi < 0 || lo < 0) return XST_FAILURE;
+        hash[i] = (BYTE)((hi << 4) | lo);
+    }
+
+    return XST_SUCCESS;
+}
+
+// Word at a time and always the whole digest, so the time taken does not
+// tell how many leading bytes matched
+static u8 hash_equal(const BYTE *a, const BYTE *b) {
+    u32 x, y, diff = 0;
+
+    for (int i = 0; i < HASH_LEN; i += 4) {
+        memcpy(&x, &a[i], sizeof(x));
+        memcpy(&y, &b[i], sizeof(y));
+        diff |= x ^ y;
+    }
+
+    return diff == 0;
+}
+
+void sha256_string(const char *input, size_t len, BYTE output[32]) {
     SHA256_CTX ctx;
     sha256Init(&ctx);
-    sha256Update(&ctx, (BYTE *)input, strlen(input));
+    sha256Update(&ctx, (BYTE *)input, len);
     sha256Final(&ctx, output);
 }
 
-static void uart_init(void) {
-    XUartPs_Config *cfg;
+// Hashes into each request's result. Pass-through and streamed requests,
+// and the lanes past a short batch, hash nothing.
+static void sha256_batch(crypto_request_t *const batch[], int count) {
+    SHA256_X4_CTX ctx;
+    const BYTE *data[SHA256_X4_LANES] = {NULL};
+    size_t len[SHA256_X4_LANES] = {0};
+    BYTE hash[SHA256_X4_LANES][SHA256_BLOCK_SIZE];
+    u8 hashed[SHA256_X4_LANES] = {0};
+    int i;
+
+    for (i = 0; i < count; i++) {
+        hashed[i] = batch[i]->type != CMD_NONE && !batch[i]->streamed;
+    }
 
-    cfg = XUartPs_LookupConfig(UART_BASEADDR);
-    if (!cfg) {
-        while (1) {
+    if (count == 1) {
+        if (hashed[0]) {
+            sha256_string(batch[0]->input_text, batch[0]->input_len,
+                          batch[0]->result.hash);
         }
+        return;
     }
 
-    if (XUartPs_CfgInitialize(&UartPs, cfg, cfg->BaseAddress) != XST_SUCCESS) {
-        while (1) {
+    for (i = 0; i < count; i++) {
+        if (hashed[i]) {
+            data[i] = (const BYTE *)batch[i]->input_text;
+            len[i]  = batch[i]->input_len;
         }
     }
 
-    XUartPs_SetBaudRate(&UartPs, 115200);
-}
+    sha256_x4_init(&ctx);
+    sha256_x4_update(&ctx, data, len);
+    sha256_x4_final(&ctx, hash);
 
-static int uart_poll_rx(uint8_t *b) {
-    if (XUartPs_IsReceiveData(UartPs.Config.BaseAddress)) {
-        *b = XUartPs_ReadReg(UartPs.Config.BaseAddress, XUARTPS_FIFO_OFFSET);
-        return 1;
+    for (i = 0; i < count; i++) {
+        if (hashed[i]) memcpy(batch[i]->result.hash, hash[i], HASH_LEN);
     }
-    return 0;
-}
-
-static void uart_tx_byte(uint8_t b) {
-    while (XUartPs_IsTransmitFull(UartPs.Config.BaseAddress)) {
-    }
-
-    XUartPs_WriteReg(UartPs.Config.BaseAddress, XUARTPS_FIFO_OFFSET, b);
 }
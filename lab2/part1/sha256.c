@@ -28,8 +28,15 @@
 #define SIG0(x) (ROTRIGHT(x,7) ^ ROTRIGHT(x,18) ^ ((x) >> 3))
 #define SIG1(x) (ROTRIGHT(x,17) ^ ROTRIGHT(x,19) ^ ((x) >> 10))
 
+// 1 selects the unrolled compression with a 16-word schedule, 0 the original
+// rolled loop, kept for comparison (see bench/sha256_bench.c).
+#ifndef SHA256_UNROLLED
+#define SHA256_UNROLLED 1
+#endif
+
 /**************************** VARIABLES *****************************/
-static const WORD k[64] = {
+// Round constants, also used by sha256_x4.c
+const WORD sha256K[64] = {
 	0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
 	0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
 	0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
@@ -41,6 +48,74 @@ static const WORD k[64] = {
 };
 
 /*********************** FUNCTION DEFINITIONS ***********************/
+#if SHA256_UNROLLED
+// Big-endian load from any alignment, a single ldr + rev on the Cortex-A9.
+static inline WORD load_be32(const BYTE *p)
+{
+	WORD w;
+
+	memcpy(&w, p, sizeof(w));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	w = __builtin_bswap32(w);
+#endif
+	return w;
+}
+
+// Schedule words for rounds 0-15 come from the block, later ones replace
+// the word 16 rounds back in a circular w[16].
+#define LOADW(i) (w[i] = load_be32(&data[(i) * 4]))
+#define NEXTW(i) (w[(i) & 15] += SIG1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + \
+                  SIG0(w[((i) - 15) & 15]))
+
+// One round without moving the working variables: the caller rotates the
+// names instead, d becomes the next e and h the next a.
+#define ROUND(a,b,c,d,e,f,g,h,i,W) \
+	t1 = h + EP1(e) + CH(e,f,g) + sha256K[i] + W(i); \
+	d += t1; \
+	h = t1 + EP0(a) + MAJ(a,b,c);
+
+#define ROUNDS8(i,W) \
+	ROUND(a,b,c,d,e,f,g,h,(i) + 0,W) \
+	ROUND(h,a,b,c,d,e,f,g,(i) + 1,W) \
+	ROUND(g,h,a,b,c,d,e,f,(i) + 2,W) \
+	ROUND(f,g,h,a,b,c,d,e,(i) + 3,W) \
+	ROUND(e,f,g,h,a,b,c,d,(i) + 4,W) \
+	ROUND(d,e,f,g,h,a,b,c,(i) + 5,W) \
+	ROUND(c,d,e,f,g,h,a,b,(i) + 6,W) \
+	ROUND(b,c,d,e,f,g,h,a,(i) + 7,W)
+
+void sha256Transform(SHA256_CTX *ctx, const BYTE data[])
+{
+	WORD a, b, c, d, e, f, g, h, t1, w[16];
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+	f = ctx->state[5];
+	g = ctx->state[6];
+	h = ctx->state[7];
+
+	ROUNDS8(0, LOADW)
+	ROUNDS8(8, LOADW)
+	ROUNDS8(16, NEXTW)
+	ROUNDS8(24, NEXTW)
+	ROUNDS8(32, NEXTW)
+	ROUNDS8(40, NEXTW)
+	ROUNDS8(48, NEXTW)
+	ROUNDS8(56, NEXTW)
+
+	ctx->state[0] += a;
+	ctx->state[1] += b;
+	ctx->state[2] += c;
+	ctx->state[3] += d;
+	ctx->state[4] += e;
+	ctx->state[5] += f;
+	ctx->state[6] += g;
+	ctx->state[7] += h;
+}
+#else
 void sha256Transform(SHA256_CTX *ctx, const BYTE data[])
 {
 	WORD a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
@@ -63,7 +138,7 @@ void sha256Transform(SHA256_CTX *ctx, const BYTE data[])
 	h = ctx->state[7];
 
 	for (i = 0; i < 64; ++i){
-		t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
+		t1 = h + EP1(e) + CH(e,f,g) + sha256K[i] + m[i];
 		t2 = EP0(a) + MAJ(a,b,c);
 		h = g;
 		g = f;
@@ -84,6 +159,7 @@ void sha256Transform(SHA256_CTX *ctx, const BYTE data[])
 	ctx->state[6] += g;
 	ctx->state[7] += h;
 }
+#endif
 
 void sha256Init(SHA256_CTX *ctx)
 {
@@ -101,16 +177,37 @@ void sha256Init(SHA256_CTX *ctx)
 
 void sha256Update(SHA256_CTX *ctx, const BYTE data[], size_t len)
 {
-	WORD i;
+	size_t fill;
 
-	for (i = 0; i < len; ++i){
-		ctx->data[ctx->datalen] = data[i];
-		ctx->datalen++;
-		if (ctx->datalen == 64){
-			sha256Transform(ctx, ctx->data);
-			ctx->bitlen += 512;
-			ctx->datalen = 0;
+	// Top up a partial block left by the previous call.
+	if (ctx->datalen > 0){
+		fill = 64 - ctx->datalen;
+		if (len < fill){
+			memcpy(&ctx->data[ctx->datalen], data, len);
+			ctx->datalen += len;
+			return;
 		}
+
+		memcpy(&ctx->data[ctx->datalen], data, fill);
+		sha256Transform(ctx, ctx->data);
+		ctx->bitlen += 512;
+		ctx->datalen = 0;
+		data += fill;
+		len -= fill;
+	}
+
+	// Whole blocks are hashed straight from the caller's buffer.
+	while (len >= 64){
+		sha256Transform(ctx, data);
+		ctx->bitlen += 512;
+		data += 64;
+		len -= 64;
+	}
+
+	// Keep the tail for the next call or sha256Final().
+	if (len > 0){
+		memcpy(ctx->data, data, len);
+		ctx->datalen = len;
 	}
 }
 
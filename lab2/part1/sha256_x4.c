@@ -0,0 +1,270 @@
+/*
+ * sha256_x4.c
+ *
+ * The state and message words are transposed into vectors, word i of every
+ * lane in one register, and the rounds are the scalar ones with each
+ * operation applied to the four lanes at once.
+ */
+
+#include <string.h>
+
+#include "sha256_x4.h"
+
+// Defined in sha256.c
+extern const WORD sha256K[64];
+void sha256Transform(SHA256_CTX *ctx, const BYTE data[]);
+
+#ifndef SHA256_X4_SCALAR
+
+#if defined(__arm__) && !defined(__ARM_NEON)
+#error "sha256_x4.c needs NEON, build it with -mfpu=neon or define SHA256_X4_SCALAR"
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+
+typedef uint32x4_t VEC;
+
+#define V_LOAD(p)      vld1q_u32(p)
+#define V_STORE(p,v)   vst1q_u32(p,v)
+#define V_SET1(x)      vdupq_n_u32(x)
+#define V_ADD(a,b)     vaddq_u32(a,b)
+#define V_XOR(a,b)     veorq_u32(a,b)
+#define V_SHR(x,n)     vshrq_n_u32(x,n)
+#define V_ROTR(x,n)    vsriq_n_u32(vshlq_n_u32(x,32 - (n)),x,n)
+// Bit selects: f where e is set, else g; c where a and b differ, else b
+#define V_CH(e,f,g)    vbslq_u32(e,f,g)
+#define V_MAJ(a,b,c)   vbslq_u32(veorq_u32(a,b),c,b)
+#else
+#include <emmintrin.h>
+
+typedef __m128i VEC;
+
+#define V_LOAD(p)      _mm_load_si128((const __m128i *)(p))
+#define V_STORE(p,v)   _mm_store_si128((__m128i *)(p),v)
+#define V_SET1(x)      _mm_set1_epi32((int)(x))
+#define V_ADD(a,b)     _mm_add_epi32(a,b)
+#define V_XOR(a,b)     _mm_xor_si128(a,b)
+#define V_SHR(x,n)     _mm_srli_epi32(x,n)
+#define V_ROTR(x,n)    _mm_or_si128(_mm_srli_epi32(x,n),_mm_slli_epi32(x,32 - (n)))
+#define V_CH(e,f,g)    _mm_xor_si128(_mm_and_si128(e,f),_mm_andnot_si128(e,g))
+#define V_MAJ(a,b,c)   _mm_or_si128(_mm_and_si128(a,b),_mm_and_si128(c,_mm_or_si128(a,b)))
+#endif
+
+#define V_EP0(x)  V_XOR(V_XOR(V_ROTR(x,2),V_ROTR(x,13)),V_ROTR(x,22))
+#define V_EP1(x)  V_XOR(V_XOR(V_ROTR(x,6),V_ROTR(x,11)),V_ROTR(x,25))
+#define V_SIG0(x) V_XOR(V_XOR(V_ROTR(x,7),V_ROTR(x,18)),V_SHR(x,3))
+#define V_SIG1(x) V_XOR(V_XOR(V_ROTR(x,17),V_ROTR(x,19)),V_SHR(x,10))
+
+static inline WORD load_be32(const BYTE *p)
+{
+	return ((WORD)p[0] << 24) | ((WORD)p[1] << 16) | ((WORD)p[2] << 8) | p[3];
+}
+
+// Word i of the four blocks, one lane each
+static inline VEC load_words(const BYTE *const block[SHA256_X4_LANES], int i)
+{
+	WORD lanes[SHA256_X4_LANES] __attribute__((aligned(16)));
+	int l;
+
+	for (l = 0; l < SHA256_X4_LANES; ++l)
+		lanes[l] = load_be32(&block[l][i * 4]);
+
+	return V_LOAD(lanes);
+}
+
+#define LOADW(i) (w[i] = load_words(block, i))
+#define NEXTW(i) (w[(i) & 15] = V_ADD(V_ADD(w[(i) & 15], V_SIG1(w[((i) - 2) & 15])), \
+                  V_ADD(w[((i) - 7) & 15], V_SIG0(w[((i) - 15) & 15]))))
+
+// Same name rotation as the unrolled scalar kernel
+#define ROUND(a,b,c,d,e,f,g,h,i,W) \
+	t1 = V_ADD(V_ADD(h, V_EP1(e)), V_ADD(V_CH(e,f,g), V_ADD(V_SET1(sha256K[i]), W(i)))); \
+	d = V_ADD(d, t1); \
+	h = V_ADD(t1, V_ADD(V_EP0(a), V_MAJ(a,b,c)));
+
+#define ROUNDS8(i,W) \
+	ROUND(a,b,c,d,e,f,g,h,(i) + 0,W) \
+	ROUND(h,a,b,c,d,e,f,g,(i) + 1,W) \
+	ROUND(g,h,a,b,c,d,e,f,(i) + 2,W) \
+	ROUND(f,g,h,a,b,c,d,e,(i) + 3,W) \
+	ROUND(e,f,g,h,a,b,c,d,(i) + 4,W) \
+	ROUND(d,e,f,g,h,a,b,c,(i) + 5,W) \
+	ROUND(c,d,e,f,g,h,a,b,(i) + 6,W) \
+	ROUND(b,c,d,e,f,g,h,a,(i) + 7,W)
+
+// One block for each lane
+static void transform_x4(SHA256_X4_CTX *ctx, const BYTE *const block[SHA256_X4_LANES])
+{
+	WORD lanes[SHA256_X4_LANES] __attribute__((aligned(16)));
+	VEC s[8], a, b, c, d, e, f, g, h, t1, w[16];
+	int i, l;
+
+	for (i = 0; i < 8; ++i){
+		for (l = 0; l < SHA256_X4_LANES; ++l)
+			lanes[l] = ctx->lane[l].state[i];
+		s[i] = V_LOAD(lanes);
+	}
+
+	a = s[0];
+	b = s[1];
+	c = s[2];
+	d = s[3];
+	e = s[4];
+	f = s[5];
+	g = s[6];
+	h = s[7];
+
+	for (i = 0; i < 16; i += 8){
+		ROUNDS8(i, LOADW)
+	}
+	for ( ; i < 64; i += 8){
+		ROUNDS8(i, NEXTW)
+	}
+
+	s[0] = V_ADD(s[0], a);
+	s[1] = V_ADD(s[1], b);
+	s[2] = V_ADD(s[2], c);
+	s[3] = V_ADD(s[3], d);
+	s[4] = V_ADD(s[4], e);
+	s[5] = V_ADD(s[5], f);
+	s[6] = V_ADD(s[6], g);
+	s[7] = V_ADD(s[7], h);
+
+	for (i = 0; i < 8; ++i){
+		V_STORE(lanes, s[i]);
+		for (l = 0; l < SHA256_X4_LANES; ++l)
+			ctx->lane[l].state[i] = lanes[l];
+	}
+}
+#else
+static void transform_x4(SHA256_X4_CTX *ctx, const BYTE *const block[SHA256_X4_LANES])
+{
+	int l;
+
+	for (l = 0; l < SHA256_X4_LANES; ++l)
+		sha256Transform(&ctx->lane[l], block[l]);
+}
+#endif
+
+void sha256_x4_init(SHA256_X4_CTX *ctx)
+{
+	int l;
+
+	for (l = 0; l < SHA256_X4_LANES; ++l)
+		sha256Init(&ctx->lane[l]);
+}
+
+// The lane's next full block, from its buffer once topped up or straight
+// from the input. NULL, with nothing consumed, if there is not a whole block.
+static const BYTE *next_block(SHA256_CTX *lane, const BYTE **data, size_t *len)
+{
+	const BYTE *block;
+	size_t fill;
+
+	if (lane->datalen > 0){
+		fill = 64 - lane->datalen;
+		if (*len < fill)
+			return NULL;
+
+		memcpy(&lane->data[lane->datalen], *data, fill);
+		lane->datalen = 0;
+		*data += fill;
+		*len -= fill;
+		return lane->data;
+	}
+
+	if (*len < 64)
+		return NULL;
+
+	block = *data;
+	*data += 64;
+	*len -= 64;
+	return block;
+}
+
+void sha256_x4_update(SHA256_X4_CTX *ctx, const BYTE *const data[SHA256_X4_LANES],
+                      const size_t len[SHA256_X4_LANES])
+{
+	const BYTE *in[SHA256_X4_LANES], *block[SHA256_X4_LANES];
+	size_t left[SHA256_X4_LANES];
+	int l, ready;
+
+	for (l = 0; l < SHA256_X4_LANES; ++l){
+		in[l] = data[l];
+		left[l] = len[l];
+	}
+
+	for (;;){
+		ready = 0;
+		for (l = 0; l < SHA256_X4_LANES; ++l){
+			block[l] = next_block(&ctx->lane[l], &in[l], &left[l]);
+			ready += block[l] != NULL;
+		}
+
+		if (ready < SHA256_X4_LANES)
+			break;
+
+		transform_x4(ctx, block);
+		for (l = 0; l < SHA256_X4_LANES; ++l)
+			ctx->lane[l].bitlen += 512;
+	}
+
+	// Lanes out of step finish on their own
+	for (l = 0; l < SHA256_X4_LANES; ++l){
+		if (block[l] != NULL){
+			sha256Transform(&ctx->lane[l], block[l]);
+			ctx->lane[l].bitlen += 512;
+		}
+		if (left[l] > 0)
+			sha256Update(&ctx->lane[l], in[l], left[l]);
+	}
+}
+
+void sha256_x4_final(SHA256_X4_CTX *ctx,
+                     BYTE hash[SHA256_X4_LANES][SHA256_BLOCK_SIZE])
+{
+	BYTE pad[SHA256_X4_LANES][128];
+	const BYTE *block[SHA256_X4_LANES];
+	int blocks[SHA256_X4_LANES];
+	unsigned long long bitlen;
+	SHA256_CTX *lane;
+	WORD n;
+	int i, l, all_two = 1;
+
+	// The padded tail of each lane, one block or two
+	for (l = 0; l < SHA256_X4_LANES; ++l){
+		lane = &ctx->lane[l];
+		n = lane->datalen;
+		blocks[l] = n < 56 ? 1 : 2;
+		all_two &= blocks[l] == 2;
+
+		memcpy(pad[l], lane->data, n);
+		pad[l][n++] = 0x80;
+		memset(&pad[l][n], 0, blocks[l] * 64 - n);
+
+		bitlen = lane->bitlen + lane->datalen * 8;
+		for (i = 0; i < 8; ++i)
+			pad[l][blocks[l] * 64 - 1 - i] = (BYTE)(bitlen >> (i * 8));
+	}
+
+	for (l = 0; l < SHA256_X4_LANES; ++l)
+		block[l] = pad[l];
+	transform_x4(ctx, block);
+
+	if (all_two){
+		for (l = 0; l < SHA256_X4_LANES; ++l)
+			block[l] = &pad[l][64];
+		transform_x4(ctx, block);
+	} else {
+		for (l = 0; l < SHA256_X4_LANES; ++l){
+			if (blocks[l] == 2)
+				sha256Transform(&ctx->lane[l], &pad[l][64]);
+		}
+	}
+
+	for (l = 0; l < SHA256_X4_LANES; ++l){
+		for (i = 0; i < 32; ++i)
+			hash[l][i] = (BYTE)(ctx->lane[l].state[i / 4] >> (24 - (i % 4) * 8));
+	}
+}
@@ -0,0 +1,54 @@
+/*
+ * sha256_x4.h
+ *
+ * Multi-buffer SHA-256: four independent messages hashed together, one per
+ * 32-bit SIMD lane, NEON on the Cortex-A9 and SSE2 on x86. With
+ * SHA256_X4_SCALAR defined, or on a host with neither, the lanes go through
+ * sha256Transform() one after the other. That is slower than hashing each
+ * message with sha256Update(), so on ARM sha256_x4.c is built with
+ * -mfpu=neon on its own and stops with an error if NEON is still missing,
+ * instead of falling back quietly.
+ *
+ * The NEON registers are the FPU registers, which the Zynq port saves only
+ * for tasks that asked for it. Call sha256_x4_*() only from a task that has
+ * called portTASK_USES_FLOATING_POINT(), never from an interrupt.
+ *
+ * Lanes advance together while each has a full block to hash. When they run
+ * out at different points, for messages of different lengths, the rest of
+ * each lane is hashed on its own, so the gain comes from messages of similar
+ * length. Each lane gives the same digest as sha256Init/Update/Final.
+ */
+
+#ifndef SHA256_X4_H
+#define SHA256_X4_H
+
+#include <stddef.h>
+
+#include "sha256.h"
+
+#define SHA256_X4_LANES 4
+
+#if defined(SHA256_X4_SCALAR)
+#define SHA256_X4_ENGINE "scalar"
+#elif defined(__ARM_NEON) || defined(__arm__)
+// Files other than sha256_x4.c are built without NEON on ARM
+#define SHA256_X4_ENGINE "neon"
+#elif defined(__SSE2__)
+#define SHA256_X4_ENGINE "sse2"
+#else
+#define SHA256_X4_SCALAR
+#define SHA256_X4_ENGINE "scalar"
+#endif
+
+typedef struct {
+	SHA256_CTX lane[SHA256_X4_LANES];
+} SHA256_X4_CTX;
+
+void sha256_x4_init(SHA256_X4_CTX *ctx);
+// A lane with len 0 may have a NULL data pointer
+void sha256_x4_update(SHA256_X4_CTX *ctx, const BYTE *const data[SHA256_X4_LANES],
+                      const size_t len[SHA256_X4_LANES]);
+void sha256_x4_final(SHA256_X4_CTX *ctx,
+                     BYTE hash[SHA256_X4_LANES][SHA256_BLOCK_SIZE]);
+
+#endif   // SHA256_X4_H
@@ -0,0 +1,65 @@
+/*
+ * uart_config.h
+ *
+ * Link configuration shared by the PS UART drivers: baud rate selection at
+ * run time with the divisor error reported, XON/XOFF flow control driven by
+ * the receive buffer level, and line error counters.
+ *
+ * On the Zybo, UART1 reaches the USB bridge through MIO 48/49 only, so there
+ * are no RTS/CTS lines and flow control has to be in band.
+ */
+
+#ifndef UART_CONFIG_H_
+#define UART_CONFIG_H_
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xuartps.h"
+
+#include <stddef.h>
+
+// Macros
+#define UART_MAX_BAUD           921600
+#define UART_MAX_BAUD_ERROR_PPM 30000 // 3 %, the limit XUartPs_SetBaudRate uses
+
+#define UART_XON  0x11 // DC1
+#define UART_XOFF 0x13 // DC3
+
+// Interrupt and status bits that report a damaged or lost character
+#define UART_ERROR_MASK \
+    (XUARTPS_IXR_OVER | XUARTPS_IXR_FRAMING | XUARTPS_IXR_PARITY)
+
+// Divisors chosen for a requested rate and what the hardware really runs at
+typedef struct {
+    u32 requested;
+    u32 actual;
+    s32 errorPpm; // (actual - requested) / requested, in parts per million
+    u16 cd;       // BAUDGEN
+    u8 bdiv;      // BAUDDIV
+} UartBaudInfo;
+
+typedef struct {
+    u32 overrun; // RX FIFO full when a character arrived
+    u32 framing; // Missing stop bit
+    u32 parity;
+} UartErrorCounts;
+
+// Receive side XON/XOFF, levels are bytes waiting in the receive buffer
+typedef struct {
+    u8 enabled;
+    u8 stopped; // XOFF sent, XON not yet
+    u32 highWater;
+    u32 lowWater;
+    u32 xoffCount;
+} UartFlowControl;
+
+// Function prototypes
+int UART_calcBaud(u32 InputClockHz, u32 baud, UartBaudInfo *info);
+int UART_setBaud(XUartPs *InstancePtr, u32 baud, UartBaudInfo *info);
+int UART_formatBaud(char *buf, size_t size, const UartBaudInfo *info);
+void UART_flowInit(UartFlowControl *flow, u32 bufferSize, u8 enabled);
+void UART_flowUpdate(u32 BaseAddress, UartFlowControl *flow, u32 level);
+void UART_countErrors(u32 isrStatus, UartErrorCounts *counts);
+void UART_pollErrors(u32 BaseAddress, UartErrorCounts *counts);
+
+#endif /* UART_CONFIG_H_ */
@@ -0,0 +1,89 @@
+/*
+ * uart_frame.h
+ *
+ * Binary command protocol for the lab2 CLIs, sharing the UART with the text
+ * menus. A 0x00 byte at the menu prompt switches the CLI to binary mode, it
+ * goes back to the menu on FRAME_CMD_TEXT.
+ *
+ * A packet is a 6-byte header, the payload and a CRC-16, little-endian:
+ *
+ *   cmd | status | id (2) | len (2) | payload (len) | crc (2)
+ *
+ * COBS-encoded and terminated by 0x00, so a frame never contains the
+ * delimiter and a receiver can resynchronize on the next 0x00 after noise.
+ * The CRC is CRC-16/CCITT-FALSE over the header and payload. Responses carry
+ * the request's cmd with FRAME_RESPONSE set and its id, so a host can keep
+ * many requests in flight and match the answers up.
+ *
+ * Frame bytes can take the XON/XOFF values, so software flow control is off
+ * in binary mode. Instead the host keeps no more than FRAME_RX_WINDOW bytes
+ * of requests unanswered, which always fits in the UART receive buffer.
+ *
+ * Build with FRAME_NO_RTOS for the host, which leaves only the codec.
+ */
+
+#ifndef UART_FRAME_H_
+#define UART_FRAME_H_
+
+#include "xil_types.h"
+#include "xstatus.h"
+
+#include <stddef.h>
+
+// Macros
+#define FRAME_DELIMITER   0x00
+#define FRAME_HEADER_LEN  6
+#define FRAME_CRC_LEN     2
+#define FRAME_MAX_PAYLOAD 512
+#define FRAME_MAX_RAW     (FRAME_HEADER_LEN + FRAME_MAX_PAYLOAD + FRAME_CRC_LEN)
+// COBS adds one byte per 254, plus the leading code and the delimiter
+#define FRAME_MAX_WIRE (FRAME_MAX_RAW + FRAME_MAX_RAW / 254 + 2)
+
+#define FRAME_RESPONSE  0x80 // Set in cmd on every response
+#define FRAME_RX_WINDOW 768  // Request bytes a host may have in flight, the
+                             // 3/4 of UART_RX_BUFFER_LEN that XOFF allowed
+
+// Commands, both CLIs answer PING and TEXT
+#define FRAME_CMD_PING   0x01 // Echoes the payload
+#define FRAME_CMD_TEXT   0x02 // Back to the text menu
+#define FRAME_CMD_HASH   0x10 // lab2/part1: payload in, 32-byte SHA-256 out
+#define FRAME_CMD_VERIFY 0x11 // lab2/part1: 32-byte hash + data in, match out
+#define FRAME_CMD_LED    0x20 // lab2/part2: brightness, color
+#define FRAME_CMD_SSD    0x21 // lab2/part2: two characters
+#define FRAME_CMD_BAUD   0x22 // lab2/part2: u32 rate, applied after the reply
+
+// Response status
+#define FRAME_OK          0
+#define FRAME_ERR_CMD     1 // Unknown command
+#define FRAME_ERR_LEN     2 // Wrong payload length
+#define FRAME_ERR_ARG     3 // Payload out of range
+#define FRAME_ERR_CORRUPT 4 // Sent with id 0xFFFF for a frame that failed CRC
+
+#define FRAME_ID_UNKNOWN 0xFFFF
+
+typedef struct {
+    u8 cmd;
+    u8 status; // 0 in requests
+    u16 id;
+    u16 len;
+    u8 payload[FRAME_MAX_PAYLOAD];
+} FramePacket;
+
+// Function prototypes
+u16 FRAME_crc16(const u8 *data, size_t len);
+size_t FRAME_cobsEncode(const u8 *src, size_t len, u8 *dst);
+size_t FRAME_cobsDecode(const u8 *src, size_t len, u8 *dst);
+size_t FRAME_pack(u8 *wire, u8 cmd, u8 status, u16 id, const void *payload,
+                  u16 len);
+int FRAME_unpack(const u8 *raw, size_t len, FramePacket *pkt);
+
+#ifndef FRAME_NO_RTOS
+extern u32 frame_rx_count;
+extern u32 frame_rx_errors; // Frames dropped for CRC, length or COBS errors
+
+void FRAME_reset(void);
+int FRAME_receive(FramePacket *pkt);
+void FRAME_send(u8 cmd, u8 status, u16 id, const void *payload, u16 len);
+#endif
+
+#endif /* UART_FRAME_H_ */
@@ -0,0 +1,322 @@
+/*
+ * uart_stream.c
+ *
+ * Interrupt-driven PS UART. The RX FIFO raises an interrupt once
+ * UART_RX_TRIGGER bytes are waiting, or after UART_RX_TIMEOUT of idle line
+ * for the tail of a message, and the handler moves everything in the FIFO
+ * to the RX stream buffer in one go.
+ *
+ * The TX-empty interrupt is only enabled while the TX stream buffer has data.
+ * While it is enabled the handler is the only reader of the buffer; while it
+ * is disabled the writer primes the FIFO itself, so the two never read at the
+ * same time.
+ *
+ * With UART_USE_XONXOFF the link sends XOFF once the RX stream buffer is
+ * three quarters full and XON when the reader has emptied it to a quarter,
+ * so a fast sender pauses instead of losing bytes.
+ */
+
+#include "uart_stream.h"
+#include "task.h"
+
+#include <string.h>
+
+// -------------------------------------------------
+// Global variables
+// -------------------------------------------------
+XUartPs UartPs;
+
+static StreamBufferHandle_t rx_stream = NULL;
+static StreamBufferHandle_t tx_stream = NULL;
+static SemaphoreHandle_t tx_mutex     = NULL; // Serializes writers
+
+// Bytes taken from rx_stream but not consumed yet, see uart_peek(). There is
+// one reader task, so these need no lock.
+static u8 rx_ahead[UART_FIFO_DEPTH];
+static size_t rx_ahead_pos, rx_ahead_len;
+
+UartBaudInfo uart_baud;
+UartFlowControl uart_flow;
+UartErrorCounts uart_errors;
+volatile u32 uart_rx_irq_count;
+volatile u32 uart_rx_dropped;
+volatile u32 uart_tx_irq_count;
+
+// -------------------------------------------------
+// Interrupt Handler
+// -------------------------------------------------
+static void drain_rx_fifo(BaseType_t *higher_priority_task_woken) {
+    u8 chunk[UART_FIFO_DEPTH];
+    size_t count, sent;
+
+    do {
+        count = 0;
+        while (count < sizeof(chunk) && XUartPs_IsReceiveData(UART_BASEADDR)) {
+            chunk[count++] = XUartPs_ReadReg(UART_BASEADDR, XUARTPS_FIFO_OFFSET);
+        }
+
+        sent = xStreamBufferSendFromISR(rx_stream, chunk, count,
+                                        higher_priority_task_woken);
+        uart_rx_dropped += count - sent;
+    } while (count == sizeof(chunk));
+
+    UART_flowUpdate(UART_BASEADDR, &uart_flow,
+                    xStreamBufferBytesAvailable(rx_stream));
+}
+
+// The FIFO is empty when TXEMPTY fires, so it can be filled without polling
+// TXFULL. One slot is left for an XON/XOFF the RX path may have written.
+static void fill_tx_fifo(BaseType_t *higher_priority_task_woken) {
+    u8 chunk[UART_FIFO_DEPTH - 1];
+    size_t count, i;
+
+    count = xStreamBufferReceiveFromISR(tx_stream, chunk, sizeof(chunk),
+                                        higher_priority_task_woken);
+    if (count == 0) {
+        // Nothing left to send, the next writer primes the FIFO again
+        XUartPs_WriteReg(UART_BASEADDR, XUARTPS_IDR_OFFSET, XUARTPS_IXR_TXEMPTY);
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        XUartPs_WriteReg(UART_BASEADDR, XUARTPS_FIFO_OFFSET, chunk[i]);
+    }
+}
+
+void uart_interrupt_handler(void *CallBackRef) {
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    u32 isr_status;
+
+    (void)CallBackRef;
+
+    isr_status = XUartPs_ReadReg(UART_BASEADDR, XUARTPS_ISR_OFFSET) &
+                 XUartPs_ReadReg(UART_BASEADDR, XUARTPS_IMR_OFFSET);
+
+    // Clear before draining, so a trigger raised while draining is kept
+    XUartPs_WriteReg(UART_BASEADDR, XUARTPS_ISR_OFFSET, isr_status);
+
+    if (isr_status & UART_ERROR_MASK) {
+        UART_countErrors(isr_status, &uart_errors);
+    }
+
+    if (isr_status & (XUARTPS_IXR_RXOVR | XUARTPS_IXR_TOUT)) {
+        ++uart_rx_irq_count;
+        drain_rx_fifo(&higher_priority_task_woken);
+    }
+
+    if (isr_status & XUARTPS_IXR_TXEMPTY) {
+        ++uart_tx_irq_count;
+        fill_tx_fifo(&higher_priority_task_woken);
+    }
+
+    if (isr_status & XUARTPS_IXR_TOUT) {
+        // Re-arm the receive timeout for the next burst
+        XUartPs_WriteReg(UART_BASEADDR, XUARTPS_CR_OFFSET,
+                         XUartPs_ReadReg(UART_BASEADDR, XUARTPS_CR_OFFSET) |
+                             XUARTPS_CR_TORST);
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+// -------------------------------------------------
+// Transmit
+// -------------------------------------------------
+
+// Starts the transmitter if it is idle, caller holds tx_mutex
+static void start_tx(void) {
+    u8 chunk[UART_FIFO_DEPTH];
+    size_t count, i;
+
+    if (XUartPs_ReadReg(UART_BASEADDR, XUARTPS_IMR_OFFSET) &
+        XUARTPS_IXR_TXEMPTY) {
+        return; // The interrupt is already refilling the FIFO
+    }
+
+    count = xStreamBufferReceive(tx_stream, chunk, sizeof(chunk), 0);
+    if (count == 0) return;
+
+    // Bytes from xil_printf may still be in the FIFO
+    for (i = 0; i < count; i++) {
+        while (XUartPs_IsTransmitFull(UART_BASEADDR)) {
+        }
+        XUartPs_WriteReg(UART_BASEADDR, XUARTPS_FIFO_OFFSET, chunk[i]);
+    }
+
+    // Drop any stale TXEMPTY event, the FIFO is not empty now
+    XUartPs_WriteReg(UART_BASEADDR, XUARTPS_ISR_OFFSET, XUARTPS_IXR_TXEMPTY);
+    XUartPs_WriteReg(UART_BASEADDR, XUARTPS_IER_OFFSET, XUARTPS_IXR_TXEMPTY);
+}
+
+// -------------------------------------------------
+// Public API
+// -------------------------------------------------
+
+// Copies buf into the TX stream buffer, blocking while it is full
+void uart_write(const void *buf, size_t len) {
+    const u8 *src = buf;
+    size_t sent;
+
+    xSemaphoreTake(tx_mutex, portMAX_DELAY);
+    while (len > 0) {
+        // Each copy is kicked off before the next one can block, so a full
+        // buffer always has the interrupt draining it
+        sent = xStreamBufferSend(tx_stream, src,
+                                 (len < UART_TX_CHUNK) ? len : UART_TX_CHUNK,
+                                 portMAX_DELAY);
+        src += sent;
+        len -= sent;
+        start_tx();
+    }
+    xSemaphoreGive(tx_mutex);
+}
+
+static size_t stream_read(void *buf, size_t len, TickType_t timeout) {
+    size_t count;
+
+    count = xStreamBufferReceive(rx_stream, buf, len, timeout);
+
+    if (uart_flow.stopped) {
+        taskENTER_CRITICAL();
+        UART_flowUpdate(UART_BASEADDR, &uart_flow,
+                        xStreamBufferBytesAvailable(rx_stream));
+        taskEXIT_CRITICAL();
+    }
+
+    return count;
+}
+
+// Blocks until at least one byte is available or the timeout expires. Bytes
+// left over from uart_peek() come first.
+size_t uart_read(void *buf, size_t len, TickType_t timeout) {
+    size_t count = rx_ahead_len - rx_ahead_pos;
+
+    if (count == 0) return stream_read(buf, len, timeout);
+
+    if (count > len) count = len;
+    memcpy(buf, &rx_ahead[rx_ahead_pos], count);
+    rx_ahead_pos += count;
+
+    return count;
+}
+
+// Points data at the received bytes without consuming them, reading up to
+// UART_FIFO_DEPTH more when none are waiting. Parsers take what they need
+// with uart_consume() and the rest is there for the next reader, whichever
+// of the menu or the frame receiver that is. Returns 0 on timeout.
+size_t uart_peek(const u8 **data, TickType_t timeout) {
+    if (rx_ahead_pos == rx_ahead_len) {
+        rx_ahead_len = stream_read(rx_ahead, sizeof(rx_ahead), timeout);
+        rx_ahead_pos = 0;
+    }
+
+    *data = &rx_ahead[rx_ahead_pos];
+    return rx_ahead_len - rx_ahead_pos;
+}
+
+void uart_consume(size_t len) {
+    size_t count = rx_ahead_len - rx_ahead_pos;
+
+    rx_ahead_pos += (len < count) ? len : count;
+}
+
+// Turns XON/XOFF on or off at run time. When turning it off while the
+// sender is paused, XON goes out first.
+void uart_set_xonxoff(u8 enabled) {
+    taskENTER_CRITICAL();
+    if (!enabled) UART_flowUpdate(UART_BASEADDR, &uart_flow, 0);
+    uart_flow.enabled = enabled && UART_USE_XONXOFF;
+    taskEXIT_CRITICAL();
+}
+
+void uart_flush_rx(void) {
+    u8 discard[32];
+
+    rx_ahead_pos = rx_ahead_len;
+
+    while (uart_read(discard, sizeof(discard), 0) > 0) {
+    }
+}
+
+// -------------------------------------------------
+// Initialization
+// -------------------------------------------------
+
+// Safe to call before the scheduler starts. Output written before
+// uart_start() is held in the TX stream buffer until the interrupt is
+// connected.
+int uart_init(void) {
+    XUartPs_Config *cfg;
+
+    cfg = XUartPs_LookupConfig(UART_BASEADDR);
+    if (NULL == cfg) {
+        return XST_FAILURE;
+    }
+
+    if (XUartPs_CfgInitialize(&UartPs, cfg, cfg->BaseAddress) != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    if (UART_setBaud(&UartPs, UART_BAUD_RATE, &uart_baud) != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+    UART_flowInit(&uart_flow, UART_RX_BUFFER_LEN, UART_USE_XONXOFF);
+    XUartPs_SetInterruptMask(&UartPs, 0);
+
+    rx_stream = xStreamBufferCreate(UART_RX_BUFFER_LEN, 1);
+    tx_stream = xStreamBufferCreate(UART_TX_BUFFER_LEN, 1);
+    tx_mutex  = xSemaphoreCreateMutex();
+    if (NULL == rx_stream || NULL == tx_stream || NULL == tx_mutex) {
+        return XST_FAILURE;
+    }
+
+    return XST_SUCCESS;
+}
+
+// The GIC must already be initialized, so call this from a task once the
+// scheduler is running (FreeRTOS sets up xInterruptController for its tick).
+int uart_start(XScuGic *IntcInstancePtr) {
+    int Status;
+
+    Status = XScuGic_Connect(IntcInstancePtr, UART_INT_IRQ_ID,
+                             (Xil_ExceptionHandler)uart_interrupt_handler,
+                             (void *)&UartPs);
+    if (Status != XST_SUCCESS) return XST_FAILURE;
+
+    XUartPs_SetFifoThreshold(&UartPs, UART_RX_TRIGGER);
+    XUartPs_SetRecvTimeout(&UartPs, UART_RX_TIMEOUT);
+
+    XScuGic_Enable(IntcInstancePtr, UART_INT_IRQ_ID);
+
+    // Only add the RX sources, TXEMPTY may already be enabled by a writer
+    XUartPs_WriteReg(UART_BASEADDR, XUARTPS_IER_OFFSET,
+                     XUARTPS_IXR_RXOVR | XUARTPS_IXR_TOUT | UART_ERROR_MASK);
+
+    return XST_SUCCESS;
+}
+
+// Waits for queued output to go out at the old rate, then switches. The
+// result, including the divisor error, is left in uart_baud.
+int uart_set_baud(u32 baud) {
+    UartBaudInfo info;
+    int Status;
+
+    if (UART_calcBaud(UartPs.Config.InputClockHz, baud, &info) != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    xSemaphoreTake(tx_mutex, portMAX_DELAY);
+    while (!xStreamBufferIsEmpty(tx_stream) ||
+           !(XUartPs_ReadReg(UART_BASEADDR, XUARTPS_SR_OFFSET) &
+             XUARTPS_SR_TXEMPTY)) {
+        vTaskDelay(1);
+    }
+
+    taskENTER_CRITICAL();
+    Status = UART_setBaud(&UartPs, baud, &uart_baud);
+    taskEXIT_CRITICAL();
+
+    xSemaphoreGive(tx_mutex);
+
+    return Status;
+}
@@ -37,6 +37,9 @@
 
 #include "pmodkypd.h"
 #include "rgb_led.h"
+#include "ssd_driver.h"
+#include "uart_frame.h"
+#include "uart_stream.h"
 #include "xuartps.h"
 
 // Device ID declarations
@@ -45,27 +48,18 @@
 #define PSHBTN_DEVICE_ID XPAR_GPIO_INPUTS_BASEADDR
 
 // UART defs
-#define UART_BASEADDR XPAR_UART1_BASEADDR
-#define RX_QUEUE_LEN  512
 #define CMD_QUEUE_LEN 16
-#define TX_QUEUE_LEN  (512 * 2) // had to be increased to work
 
 #define INPUT_TEXT_LEN 512
 
-#define POLL_DELAY_MS 10 // changed from 1000
-
 // keypad key table
 #define DEFAULT_KEYTABLE "0FED789C456B123A"
 
 // channel (subject to change)
-#define SSD_CHANNEL    1
 #define PSHBTN_CHANNEL 1
 
 // Declaring the devices
 PmodKYPD KYPDInst;
-static XUartPs UartPs;
-XGpio SSDInst;
-XGpio rgbLedInst;
 XGpio pbInst;
 
 // Command enums
@@ -77,10 +71,14 @@ enum PWM_Control {
 
 enum LED_SSD_Option {
     CMD_NONE,
-    CMD_LED = '1',
-    CMD_SSD = '2',
+    CMD_LED  = '1',
+    CMD_SSD  = '2',
+    CMD_BAUD = '3',
 };
 
+// GIC instance set up by the FreeRTOS port when the scheduler starts
+extern XScuGic xInterruptController;
+
 // Helpful macro functions
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
@@ -90,32 +88,24 @@ void InitializeKeypad(void);
 static void vKeypadTask(void *pvParameters);
 static void vRgbTask(void *pvParameters);
 static void vButtonsTask(void *pvParameters);
-static void vDisplayTask(void *pvParameters);
-static void UART_RX_Task(void *pvParameters);
-static void UART_TX_Task(void *pvParameters);
 static void CLI_Task(void *pvParameters);
-u32 SSD_decode(u8 key_value, u8 cathode);
+static void binary_mode(void);
+static void ssdShowKey(u8 key);
 enum PWM_Control LED_decode(u32 input);
 
 // UART fns
 uint8_t receive_byte(uint8_t *out_byte);
 void receive_string(char *buf, size_t buf_len);
-static void uart_init(void);
-static int uart_poll_rx(uint8_t *b);
-static void uart_tx_byte(uint8_t b);
 void print_string(const char *str);
 void flush_uart(void);
+static void print_uart_link(void);
 
 // Queue handles
-QueueHandle_t keypad_to_ssd_handle;
 QueueHandle_t pushbutton_to_led_handle;
-QueueHandle_t rgb_cmd_handle;
-QueueHandle_t rx_handle;
-QueueHandle_t tx_handle;
 
 // LED command format
 typedef struct {
-    uint8_t brightness; // 0-20
+    uint8_t brightness; // 0-RGB_PWM_MAX
     uint8_t color;      // 0-7
 } rgb_settings;
 
@@ -124,30 +114,26 @@ int main(void) {
 
     // Initialize keypad and UART
     InitializeKeypad();
-    uart_init();
+    if (uart_init() != XST_SUCCESS) {
+        while (1) {
+        }
+    }
 
-    XGpio_Initialize(&SSDInst, SSD_DEVICE_ID);
-    XGpio_SetDataDirection(&SSDInst, SSD_CHANNEL,
-                           0x0); // sets all pins as outputs
+    SSD_begin(SSD_DEVICE_ID);
 
-    // initialize LEDS and set GPIO direction to output
-    XGpio_Initialize(&rgbLedInst, RGB_LED_BASEADDR);
-    XGpio_SetDataDirection(&rgbLedInst, RGB_CHANNEL, 0x0);
+    // initialize the RGB LED, its PWM runs from a timer interrupt
+    RGB_begin(RGB_LED_BASEADDR);
 
     // initialize pushbutton GPIO
     XGpio_Initialize(&pbInst, PSHBTN_DEVICE_ID);
     XGpio_SetDataDirection(&pbInst, PSHBTN_CHANNEL, 0x1);
 
     // queue creation
-    keypad_to_ssd_handle     = xQueueCreate(2, sizeof(u8));
     pushbutton_to_led_handle = xQueueCreate(1, sizeof(u32));
-
-    rgb_cmd_handle = xQueueCreate(1, sizeof(rgb_settings));
-    rx_handle      = xQueueCreate(RX_QUEUE_LEN, sizeof(char));
-    tx_handle      = xQueueCreate(TX_QUEUE_LEN, sizeof(char));
     /*****************************************************************************/
 
     print_string("Initialization Complete, System Ready!\n");
+    print_uart_link();
 
     xTaskCreate(vKeypadTask, /* The function that implements the task. */
                 "main task", /* Text name for the task, provided to assist
@@ -161,10 +147,6 @@ int main(void) {
                 tskIDLE_PRIORITY, NULL);
     xTaskCreate(vButtonsTask, "button task", configMINIMAL_STACK_SIZE, NULL,
                 tskIDLE_PRIORITY, NULL);
-    xTaskCreate(vDisplayTask, "display task", configMINIMAL_STACK_SIZE, NULL,
-                tskIDLE_PRIORITY, NULL);
-    xTaskCreate(UART_RX_Task, "uart rx task", 1024, NULL, 3, NULL);
-    xTaskCreate(UART_TX_Task, "uart tx task", 1024, NULL, 3, NULL);
     xTaskCreate(CLI_Task, "cli task", 1024, NULL, 3, NULL);
 
     vTaskStartScheduler();
@@ -173,51 +155,38 @@ int main(void) {
     return 0;
 }
 
-static void UART_RX_Task(void *pvParameters) {
-    (void)pvParameters;
-
-    uint8_t byte;
-
-    for (;;) {
-        if (uart_poll_rx(&byte)) {
-            xQueueSend(rx_handle, &byte, 0);
-        }
-        vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
-    }
-}
-
-static void UART_TX_Task(void *pvParameters) {
-    (void)pvParameters;
-
-    char c;
-
-    for (;;) {
-        if (xQueueReceive(tx_handle, &c, 0) == pdPASS) {
-            uart_tx_byte((uint8_t)c);
-        }
-        vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
-    }
-}
-
 static void CLI_Task(void *pvParameters) {
     (void)pvParameters;
 
     char buf[INPUT_TEXT_LEN];
     uint8_t out_byte;
     char *color;
+    int level;
     rgb_settings rgb = {0};
 
+    // Received bytes are queued by the UART interrupt from here on
+    if (uart_start(&xInterruptController) != XST_SUCCESS) {
+        print_string("UART interrupt setup failed\n");
+    }
+
     for (;;) {
-        print_string("\nMenu:\n1. LED Command\n2. SSD Command\n");
+        print_string("\nMenu:\n1. LED Command\n2. SSD Command\n3. Baud Rate\n");
 
         receive_byte(&out_byte);
 
+        // A frame delimiter instead of an option starts a binary session
+        if (out_byte == FRAME_DELIMITER) {
+            binary_mode();
+            continue;
+        }
+
         switch (out_byte) {
         case CMD_LED:
-            print_string("\nEnter brightness (0 to 20) and color: ");
+            print_string("\nEnter brightness (0 to 255) and color: ");
             receive_string(buf, INPUT_TEXT_LEN);
 
-            rgb.brightness = atoi(strtok(buf, " "));
+            level          = atoi(strtok(buf, " "));
+            rgb.brightness = MAX(MIN(level, RGB_PWM_MAX), 0);
             color          = strtok(NULL, " ");
 
             if (strcmp(color, "red") == 0) {
@@ -239,7 +208,9 @@ static void CLI_Task(void *pvParameters) {
                 continue;
             }
 
-            xQueueSend(rgb_cmd_handle, &rgb, 0);
+            // The PWM interrupt picks the new duty up on its next tick
+            RGB_setBrightness(rgb.brightness);
+            RGB_setColor(rgb.color);
             break;
         case CMD_SSD:
             print_string("\nEnter 2 hex digits to display: ");
@@ -250,8 +221,19 @@ static void CLI_Task(void *pvParameters) {
                 continue;
             }
 
-            xQueueSend(keypad_to_ssd_handle, buf, 0);
-            xQueueSend(keypad_to_ssd_handle, buf + 1, 0);
+            ssdShowKey(buf[0]);
+            ssdShowKey(buf[1]);
+            break;
+        case CMD_BAUD:
+            print_string("\nEnter baud rate (up to 921600): ");
+            receive_string(buf, INPUT_TEXT_LEN);
+
+            // Output after this point is at the new rate
+            if (uart_set_baud(strtoul(buf, NULL, 10)) != XST_SUCCESS) {
+                print_string("\nBaud rate out of range!\n");
+                continue;
+            }
+            print_uart_link();
             break;
         default: print_string("\nRTFM!!\n"); break;
         }
@@ -259,30 +241,111 @@ static void CLI_Task(void *pvParameters) {
     }
 }
 
+// Serves framed requests until FRAME_CMD_TEXT. Requests are answered in the
+// order they arrive, the host can send the next ones without waiting.
+static void binary_mode(void) {
+    static FramePacket pkt;
+    UartBaudInfo info;
+    u32 baud;
+    u8 status;
+
+    // Frames can hold the XON/XOFF bytes, the host paces itself instead
+    uart_set_xonxoff(0);
+    FRAME_reset();
+
+    for (;;) {
+        if (FRAME_receive(&pkt) != XST_SUCCESS) {
+            FRAME_send(FRAME_RESPONSE, FRAME_ERR_CORRUPT, FRAME_ID_UNKNOWN,
+                       NULL, 0);
+            continue;
+        }
+
+        status = FRAME_OK;
+        switch (pkt.cmd) {
+        case FRAME_CMD_PING:
+            FRAME_send(pkt.cmd | FRAME_RESPONSE, FRAME_OK, pkt.id, pkt.payload,
+                       pkt.len);
+            continue;
+
+        case FRAME_CMD_TEXT:
+            FRAME_send(pkt.cmd | FRAME_RESPONSE, FRAME_OK, pkt.id, NULL, 0);
+            uart_set_xonxoff(1);
+            return;
+
+        case FRAME_CMD_LED:
+            // Brightness, then one of the RGB_* colors
+            if (pkt.len != 2) {
+                status = FRAME_ERR_LEN;
+            } else if (pkt.payload[1] > RGB_WHITE) {
+                status = FRAME_ERR_ARG;
+            } else {
+                RGB_setBrightness(MIN(pkt.payload[0], RGB_PWM_MAX));
+                RGB_setColor(pkt.payload[1]);
+            }
+            break;
+
+        case FRAME_CMD_SSD:
+            if (pkt.len != 2) {
+                status = FRAME_ERR_LEN;
+            } else {
+                ssdShowKey(pkt.payload[0]);
+                ssdShowKey(pkt.payload[1]);
+            }
+            break;
+
+        case FRAME_CMD_BAUD:
+            if (pkt.len != 4) {
+                status = FRAME_ERR_LEN;
+                break;
+            }
+
+            baud = (u32)pkt.payload[0] | ((u32)pkt.payload[1] << 8) |
+                   ((u32)pkt.payload[2] << 16) | ((u32)pkt.payload[3] << 24);
+            if (UART_calcBaud(UartPs.Config.InputClockHz, baud, &info) !=
+                XST_SUCCESS) {
+                status = FRAME_ERR_ARG;
+                break;
+            }
+
+            // The reply goes out at the old rate, uart_set_baud() waits
+            FRAME_send(pkt.cmd | FRAME_RESPONSE, FRAME_OK, pkt.id, NULL, 0);
+            uart_set_baud(baud);
+            continue;
+
+        default: status = FRAME_ERR_CMD; break;
+        }
+
+        FRAME_send(pkt.cmd | FRAME_RESPONSE, status, pkt.id, NULL, 0);
+    }
+}
+
 static void vKeypadTask(void *pvParameters) {
     (void)pvParameters;
 
     u8 new_key;
-    u16 keystate;
+    KYPD_Event event;
     XStatus status, previous_status = KYPD_NO_KEY;
-    const TickType_t xDelay = 50;
+
+    // The SSD is refreshed from the TTC interrupt, tasks only update it
+    if (SSD_startRefresh(&xInterruptController) != XST_SUCCESS) {
+        print_string("SSD refresh timer setup failed\r\n");
+    }
+    ssdShowKey('x');
 
     while (1) {
-        // Capture state of the keypad
-        keystate = KYPD_getKeyStates(&KYPDInst);
+        // Block until the debounced keypad reports a press, release or repeat
+        KYPD_waitEvent(&KYPDInst, &event, portMAX_DELAY);
 
         // Determine which single key is pressed, if any
-        // if a key is pressed, store the value of the new key in new_key
-        status = KYPD_getKeyPressed(&KYPDInst, keystate, &new_key);
+        status = KYPD_getKeyPressed(
+            &KYPDInst, KYPD_getDebouncedKeyStates(&KYPDInst), &new_key);
 
-        // Print key detect if a new key is pressed or if status has changed
-        if (status == KYPD_SINGLE_KEY && previous_status == KYPD_NO_KEY) {
-            xQueueSend(keypad_to_ssd_handle, &new_key, 0); // put in queue
+        if (event.type == KYPD_EVENT_PRESS && status == KYPD_SINGLE_KEY) {
+            ssdShowKey(event.key);
         } else if (status == KYPD_MULTI_KEY && status != previous_status) {
             print_string("Error: Multiple keys pressed\r\n");
         }
         previous_status = status;
-        vTaskDelay(xDelay);
     }
 }
 
@@ -291,43 +354,6 @@ void InitializeKeypad(void) {
     KYPD_loadKeyTable(&KYPDInst, (u8 *)DEFAULT_KEYTABLE);
 }
 
-// This function is hard coded to translate key value codes to their binary
-// representation
-u32 SSD_decode(u8 key_value, u8 cathode) {
-    u32 result;
-
-    // key_value represents the code of the pressed key
-    switch (key_value) { // Handles the coding of the 7-seg display
-    case 48: result = 0b00111111; break; // 0
-    case 49: result = 0b00110000; break; // 1
-    case 50: result = 0b01011011; break; // 2
-    case 51: result = 0b01111001; break; // 3
-    case 52: result = 0b01110100; break; // 4
-    case 53: result = 0b01101101; break; // 5
-    case 54: result = 0b01101111; break; // 6
-    case 55: result = 0b00111000; break; // 7
-    case 56: result = 0b01111111; break; // 8
-    case 57: result = 0b01111100; break; // 9
-    case 65: result = 0b01111110; break; // A
-    case 66: result = 0b01100111; break; // B
-    case 67: result = 0b00001111; break; // C
-    case 68: result = 0b01110011; break; // D
-    case 69: result = 0b01001111; break; // E
-    case 70: result = 0b01001110; break; // F
-    default:
-        result = 0b00000000;
-        break; // default case - all seven segments are OFF
-    }
-
-    // cathode handles which display is active (left or right)
-    // by setting the MSB to 1 or 0
-    if (cathode == 0) {
-        return result;
-    } else {
-        return result | 0b10000000;
-    }
-}
-
 // Based on the button input, convert to a PWM
 // opcode for the LED
 enum PWM_Control LED_decode(u32 input) {
@@ -341,45 +367,23 @@ enum PWM_Control LED_decode(u32 input) {
 static void vRgbTask(void *pvParameters) {
     (void)pvParameters;
 
-    uint8_t color            = RGB_CYAN;
-    const TickType_t xPeriod = 20;
-    TickType_t xTimeOn       = xPeriod;
-    TickType_t xTimeOff      = 0;
     u32 input_value;
-    enum PWM_Control ctrl;
-    rgb_settings rgb_cmd;
-
-    while (1) {
-
-        if (pdPASS == xQueueReceive(rgb_cmd_handle, &rgb_cmd, 0)) {
-            xTimeOn  = MAX(MIN(rgb_cmd.brightness, xPeriod), 0);
-            xTimeOff = xPeriod - xTimeOn;
-            color    = rgb_cmd.color;
-        }
 
-        if (pdPASS ==
-            xQueueReceive(pushbutton_to_led_handle, &input_value, 0)) {
-            ctrl = LED_decode(input_value);
-            switch (ctrl) {
-            case TURN_DOWN:
-                xTimeOff = MIN(xPeriod, xTimeOff + 1);
-                xTimeOn  = xPeriod - xTimeOff;
-                break;
-            case TURN_UP:
-                xTimeOn  = MIN(xPeriod, xTimeOn + 1);
-                xTimeOff = xPeriod - xTimeOn;
-                break;
-            case UNKNOWN: break;
-            }
-        }
+    if (RGB_startPwm(&xInterruptController) != XST_SUCCESS) {
+        print_string("RGB PWM timer setup failed\r\n");
+    }
+    RGB_setBrightness(RGB_PWM_MAX);
+    RGB_setColor(RGB_CYAN);
 
-        if (xTimeOn != 0) {
-            // ensure it turns off fully :)
-            XGpio_DiscreteWrite(&rgbLedInst, RGB_CHANNEL, color);
-            vTaskDelay(xTimeOn);
+    while (1) {
+        // The PWM runs on its own, this task only wakes up while a button is
+        // held, once per poll so holding one keeps stepping the brightness
+        xQueueReceive(pushbutton_to_led_handle, &input_value, portMAX_DELAY);
+        switch (LED_decode(input_value)) {
+        case TURN_DOWN: RGB_stepBrightness(-RGB_BRIGHTNESS_STEP); break;
+        case TURN_UP: RGB_stepBrightness(RGB_BRIGHTNESS_STEP); break;
+        case UNKNOWN: break;
         }
-        XGpio_DiscreteWrite(&rgbLedInst, RGB_CHANNEL, 0);
-        vTaskDelay(xTimeOff);
     }
 }
 
@@ -388,61 +392,33 @@ static void vButtonsTask(void *pvParameters) {
 
     const TickType_t xDelay = 50;
     u32 input_value;
+    u32 last_value = 0;
     while (1) {
         input_value = XGpio_DiscreteRead(&pbInst, PSHBTN_CHANNEL);
-        xQueueOverwrite(pushbutton_to_led_handle, &input_value);
-        vTaskDelay(xDelay);
-    }
-}
-
-static void vDisplayTask(void *pvParameters) {
-    (void)pvParameters;
-
-    const TickType_t xDelay = 12; // portticks
-    u8 new_key, current_key = 'x', previous_key = 'x';
-    u32 ssd_value = 0;
-
-    while (1) {
-        if (pdPASS == xQueueReceive(keypad_to_ssd_handle, &new_key, 0)) {
-            previous_key = current_key;
-            current_key  = new_key;
+        // Nothing to send while all the buttons stay released
+        if (input_value != 0 || input_value != last_value) {
+            xQueueOverwrite(pushbutton_to_led_handle, &input_value);
         }
-
-        ssd_value = SSD_decode(current_key, (u8)1); // right side, cat = 1
-        XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, ssd_value);
-        vTaskDelay(xDelay);
-
-        ssd_value = SSD_decode(previous_key, (u8)0); // left side, cat = 0
-        XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, ssd_value);
+        last_value = input_value;
         vTaskDelay(xDelay);
     }
 }
 
-static void uart_init(void) {
-    XUartPs_Config *cfg;
-
-    cfg = XUartPs_LookupConfig(UART_BASEADDR);
-    if (!cfg) {
-        while (1) {
-        }
-    }
-
-    if (XUartPs_CfgInitialize(&UartPs, cfg, cfg->BaseAddress) != XST_SUCCESS) {
-        while (1) {
-        }
-    }
+// Shift a key into the right digit, the previous key moves to the left
+static void ssdShowKey(u8 key) {
+    static u8 current_key = 'x';
 
-    XUartPs_SetBaudRate(&UartPs, 115200);
+    // Called from both the CLI and keypad tasks
+    taskENTER_CRITICAL();
+    SSD_showChars(current_key, key); // left side, right side
+    current_key = key;
+    taskEXIT_CRITICAL();
 }
 
 uint8_t receive_byte(uint8_t *out_byte) {
-    while (1) {
-        if (xQueueReceive(rx_handle, out_byte, 0) != pdPASS) {
-            vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
-        } else {
-            return *out_byte;
-        }
+    while (uart_read(out_byte, 1, portMAX_DELAY) == 0) {
     }
+    return *out_byte;
 }
 
 void receive_string(char *buf, size_t buf_len) {
@@ -468,34 +444,29 @@ void receive_string(char *buf, size_t buf_len) {
         }
 
         buf[idx++] = recvd;
-        vTaskDelay(pdMS_TO_TICKS(POLL_DELAY_MS));
     }
 }
 
-void flush_uart(void) {
-    uint8_t dummy;
-    while (xQueueReceive(rx_handle, &dummy, 0) == pdPASS)
-        ;
-}
+void flush_uart(void) { uart_flush_rx(); }
 
-void print_string(const char *str) {
-    if (str == NULL) return;
-    for (; *str != '\0'; ++str) {
-        xQueueSend(tx_handle, str, 0);
-    }
-}
+// Reports the baud divisor error and the line error counters
+static void print_uart_link(void) {
+    char line[128];
 
-static int uart_poll_rx(uint8_t *b) {
-    if (XUartPs_IsReceiveData(UartPs.Config.BaseAddress)) {
-        *b = XUartPs_ReadReg(UartPs.Config.BaseAddress, XUARTPS_FIFO_OFFSET);
-        return 1;
-    }
-    return 0;
-}
+    UART_formatBaud(line, sizeof(line), &uart_baud);
+    print_string(line);
 
-static void uart_tx_byte(uint8_t b) {
-    while (XUartPs_IsTransmitFull(UartPs.Config.BaseAddress)) {
-    }
+    snprintf(line, sizeof(line),
+             "Overruns %lu, framing %lu, parity %lu, dropped %lu, XOFF %lu\n",
+             (unsigned long)uart_errors.overrun,
+             (unsigned long)uart_errors.framing,
+             (unsigned long)uart_errors.parity,
+             (unsigned long)uart_rx_dropped,
+             (unsigned long)uart_flow.xoffCount);
+    print_string(line);
+}
 
-    XUartPs_WriteReg(UartPs.Config.BaseAddress, XUARTPS_FIFO_OFFSET, b);
+void print_string(const char *str) {
+    if (str == NULL) return;
+    uart_write(str, strlen(str));
 }
@@ -0,0 +1,155 @@
+/*
+ * rgb_led.c
+ *
+ * Timer-driven PWM for the RGB LED. The duty of all three channels is packed
+ * into one word, so a color change is a single store that the interrupt
+ * picks up on its next tick. Tasks never block on the LED.
+ */
+
+#include "rgb_led.h"
+#include "xttcps.h"
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+// -------------------------------------------------
+// Driver state
+// -------------------------------------------------
+static XTtcPs RGBTimer;
+static u32 rgbBaseAddress;
+
+// Packed duty, red in bits 16-23, green in 8-15 and blue in 0-7
+static volatile u32 pwmDuty;
+static u8 pwmPhase;
+static u32 pwmOutput;
+
+// Color and brightness behind pwmDuty when it was set by RGB_setColor
+static u8 rgbColor = RGB_OFF;
+static u8 rgbBrightness = RGB_PWM_MAX;
+
+// -------------------------------------------------
+// Interrupt Handler
+// -------------------------------------------------
+void RGB_interruptHandler(void *CallBackRef) {
+    XTtcPs *TimerPtr = (XTtcPs *)CallBackRef;
+    u32 duty = pwmDuty;
+    u32 output = RGB_OFF;
+
+    XTtcPs_ClearInterruptStatus(TimerPtr, XTtcPs_GetInterruptStatus(TimerPtr));
+
+    // A channel is on while the phase is below its duty, 255 stays on for
+    // 255 of the 256 ticks
+    ++pwmPhase;
+    if (pwmPhase < ((duty >> 16) & 0xFF)) output |= RGB_RED;
+    if (pwmPhase < ((duty >> 8) & 0xFF)) output |= RGB_GREEN;
+    if (pwmPhase < (duty & 0xFF)) output |= RGB_BLUE;
+
+    // Only touch the GPIO on an edge
+    if (output != pwmOutput) {
+        pwmOutput = output;
+        Xil_Out32(rgbBaseAddress + RGB_GPIO_DATA_OFFSET, output);
+    }
+}
+
+// -------------------------------------------------
+// Duty control
+// -------------------------------------------------
+void RGB_setDuty(u8 red, u8 green, u8 blue) {
+    pwmDuty = ((u32)red << 16) | ((u32)green << 8) | blue;
+}
+
+static void applyColor(void) {
+    RGB_setDuty((rgbColor & RGB_RED) ? rgbBrightness : 0,
+                (rgbColor & RGB_GREEN) ? rgbBrightness : 0,
+                (rgbColor & RGB_BLUE) ? rgbBrightness : 0);
+}
+
+void RGB_setColor(u8 color) {
+    taskENTER_CRITICAL();
+    rgbColor = color & RGB_WHITE;
+    applyColor();
+    taskEXIT_CRITICAL();
+}
+
+void RGB_setBrightness(u8 brightness) {
+    taskENTER_CRITICAL();
+    rgbBrightness = brightness;
+    applyColor();
+    taskEXIT_CRITICAL();
+}
+
+// Change the brightness by step, clamped to 0-RGB_PWM_MAX
+u8 RGB_stepBrightness(int step) {
+    int level;
+
+    taskENTER_CRITICAL();
+    level = rgbBrightness + step;
+    if (level < 0) level = 0;
+    if (level > RGB_PWM_MAX) level = RGB_PWM_MAX;
+    rgbBrightness = level;
+    applyColor();
+    taskEXIT_CRITICAL();
+
+    return level;
+}
+
+// -------------------------------------------------
+// Initialization
+// -------------------------------------------------
+void RGB_begin(u32 GpioBaseAddress) {
+    rgbBaseAddress = GpioBaseAddress;
+    pwmDuty = 0;
+    pwmOutput = RGB_OFF;
+
+    // All channel 2 pins are outputs
+    Xil_Out32(rgbBaseAddress + RGB_GPIO_TRI_OFFSET, 0x0);
+    Xil_Out32(rgbBaseAddress + RGB_GPIO_DATA_OFFSET, pwmOutput);
+}
+
+// The GIC must already be initialized, so call this from a task once the
+// scheduler is running (FreeRTOS sets up xInterruptController for its tick).
+int RGB_startPwm(XScuGic *IntcInstancePtr) {
+    XTtcPs_Config *TimerConfig;
+    XInterval interval;
+    u8 prescaler;
+    int Status;
+
+    TimerConfig = XTtcPs_LookupConfig(RGB_TIMER_BASEADDR);
+    if (NULL == TimerConfig) return XST_FAILURE;
+
+    Status = XTtcPs_CfgInitialize(&RGBTimer, TimerConfig,
+                                  TimerConfig->BaseAddress);
+    if (Status == XST_DEVICE_IS_STARTED) {
+        XTtcPs_Stop(&RGBTimer);
+        Status = XTtcPs_CfgInitialize(&RGBTimer, TimerConfig,
+                                      TimerConfig->BaseAddress);
+    }
+    if (Status != XST_SUCCESS) return XST_FAILURE;
+
+    XTtcPs_SetOptions(&RGBTimer, XTTCPS_OPTION_INTERVAL_MODE |
+                                     XTTCPS_OPTION_WAVE_DISABLE);
+    XTtcPs_CalcIntervalFromFreq(&RGBTimer, RGB_PWM_TICK_HZ, &interval,
+                                &prescaler);
+    if (prescaler == 0xFF) return XST_FAILURE; // No interval fits the rate
+    XTtcPs_SetInterval(&RGBTimer, interval);
+    XTtcPs_SetPrescaler(&RGBTimer, prescaler);
+
+    Status = XScuGic_Connect(IntcInstancePtr, RGB_TIMER_IRQ_ID,
+                             (Xil_ExceptionHandler)RGB_interruptHandler,
+                             (void *)&RGBTimer);
+    if (Status != XST_SUCCESS) return XST_FAILURE;
+
+    XScuGic_Enable(IntcInstancePtr, RGB_TIMER_IRQ_ID);
+    XTtcPs_EnableInterrupts(&RGBTimer, XTTCPS_IXR_INTERVAL_MASK);
+    XTtcPs_Start(&RGBTimer);
+
+    return XST_SUCCESS;
+}
+
+void RGB_stopPwm(void) {
+    XTtcPs_Stop(&RGBTimer);
+    XTtcPs_DisableInterrupts(&RGBTimer, XTTCPS_IXR_INTERVAL_MASK);
+    Xil_Out32(rgbBaseAddress + RGB_GPIO_DATA_OFFSET, RGB_OFF);
+    pwmOutput = RGB_OFF;
+}
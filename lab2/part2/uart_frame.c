@@ -0,0 +1,219 @@
+/*
+ * uart_frame.c
+ *
+ * The codec is plain C so the host client in bench/ builds the same file.
+ * The receive side keeps its partial frame in static buffers, there is one
+ * UART and only the CLI task reads frames from it. It reads through the
+ * shared read-ahead in uart_stream.c, so the text menu sees the bytes that
+ * follow the frame that ends a binary session.
+ */
+
+#include "uart_frame.h"
+
+#include <string.h>
+
+#ifndef FRAME_NO_RTOS
+#include "uart_stream.h"
+#endif
+
+// -------------------------------------------------
+// CRC-16/CCITT-FALSE
+// -------------------------------------------------
+
+// One nibble at a time, 32 bytes of table instead of 512
+static const u16 crcNibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+u16 FRAME_crc16(const u8 *data, size_t len) {
+    u16 crc = 0xFFFF;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        crc = (u16)((crc << 4) ^ crcNibble[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (u16)((crc << 4) ^ crcNibble[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+
+    return crc;
+}
+
+// -------------------------------------------------
+// COBS
+// -------------------------------------------------
+
+// dst needs len + len / 254 + 1 bytes, the delimiter is not added
+size_t FRAME_cobsEncode(const u8 *src, size_t len, u8 *dst) {
+    size_t out = 1, codePos = 0, i;
+    u8 code = 1;
+
+    for (i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            dst[codePos] = code;
+            codePos      = out++;
+            code         = 1;
+            continue;
+        }
+
+        dst[out++] = src[i];
+        if (++code == 0xFF) {
+            dst[codePos] = code;
+            codePos      = out++;
+            code         = 1;
+        }
+    }
+    dst[codePos] = code;
+
+    return out;
+}
+
+// Decodes one frame without its delimiter, dst needs len bytes. Returns the
+// decoded length, 0 if the frame is malformed.
+size_t FRAME_cobsDecode(const u8 *src, size_t len, u8 *dst) {
+    size_t in = 0, out = 0;
+    u8 code, i;
+
+    while (in < len) {
+        code = src[in++];
+        if (code == 0 || in + code - 1 > len) return 0;
+
+        for (i = 1; i < code; i++) {
+            dst[out++] = src[in++];
+        }
+        if (code != 0xFF && in < len) dst[out++] = 0;
+    }
+
+    return out;
+}
+
+// -------------------------------------------------
+// Packets
+// -------------------------------------------------
+
+// Builds a complete frame, delimiter included, wire needs FRAME_MAX_WIRE
+// bytes. Returns the frame length, 0 if the payload is too long.
+size_t FRAME_pack(u8 *wire, u8 cmd, u8 status, u16 id, const void *payload,
+                  u16 len) {
+    u8 raw[FRAME_MAX_RAW];
+    size_t rawLen, wireLen;
+    u16 crc;
+
+    if (len > FRAME_MAX_PAYLOAD) return 0;
+
+    raw[0] = cmd;
+    raw[1] = status;
+    raw[2] = (u8)id;
+    raw[3] = (u8)(id >> 8);
+    raw[4] = (u8)len;
+    raw[5] = (u8)(len >> 8);
+    if (len > 0) memcpy(&raw[FRAME_HEADER_LEN], payload, len);
+
+    rawLen        = FRAME_HEADER_LEN + len;
+    crc           = FRAME_crc16(raw, rawLen);
+    raw[rawLen++] = (u8)crc;
+    raw[rawLen++] = (u8)(crc >> 8);
+
+    wireLen         = FRAME_cobsEncode(raw, rawLen, wire);
+    wire[wireLen++] = FRAME_DELIMITER;
+
+    return wireLen;
+}
+
+// Checks and splits a COBS-decoded frame
+int FRAME_unpack(const u8 *raw, size_t len, FramePacket *pkt) {
+    u16 payloadLen, crc;
+
+    if (len < FRAME_HEADER_LEN + FRAME_CRC_LEN) return XST_FAILURE;
+
+    payloadLen = (u16)(raw[4] | (raw[5] << 8));
+    if (payloadLen > FRAME_MAX_PAYLOAD ||
+        len != (size_t)FRAME_HEADER_LEN + payloadLen + FRAME_CRC_LEN) {
+        return XST_FAILURE;
+    }
+
+    crc = (u16)(raw[len - 2] | (raw[len - 1] << 8));
+    if (crc != FRAME_crc16(raw, len - FRAME_CRC_LEN)) return XST_FAILURE;
+
+    pkt->cmd    = raw[0];
+    pkt->status = raw[1];
+    pkt->id     = (u16)(raw[2] | (raw[3] << 8));
+    pkt->len    = payloadLen;
+    memcpy(pkt->payload, &raw[FRAME_HEADER_LEN], payloadLen);
+
+    return XST_SUCCESS;
+}
+
+#ifndef FRAME_NO_RTOS
+// -------------------------------------------------
+// UART
+// -------------------------------------------------
+u32 frame_rx_count;
+u32 frame_rx_errors;
+
+static u8 rxFrame[FRAME_MAX_WIRE]; // Encoded bytes since the last delimiter
+static u8 rxDecoded[FRAME_MAX_WIRE];
+static size_t rxFrameLen;
+static u8 rxOverflow;
+
+// Drops a partial frame left from an earlier session
+void FRAME_reset(void) {
+    rxFrameLen = 0;
+    rxOverflow = 0;
+}
+
+// Blocks until the next frame. Returns XST_FAILURE for a frame that was
+// damaged or too long, the caller decides whether to report it. Bytes are
+// consumed up to the frame's delimiter only, whatever follows stays in the
+// UART read-ahead for the next reader.
+int FRAME_receive(FramePacket *pkt) {
+    const u8 *data;
+    size_t avail, i, len;
+
+    for (;;) {
+        avail = uart_peek(&data, portMAX_DELAY);
+        if (avail == 0) continue;
+
+        for (i = 0; i < avail && data[i] != FRAME_DELIMITER; i++) {
+            if (rxFrameLen < sizeof(rxFrame)) {
+                rxFrame[rxFrameLen++] = data[i];
+            } else {
+                rxOverflow = 1;
+            }
+        }
+
+        if (i == avail) {
+            uart_consume(avail);
+            continue;
+        }
+        uart_consume(i + 1); // Through the delimiter
+
+        if (rxFrameLen == 0) continue; // Idle delimiters between frames
+
+        len        = rxFrameLen;
+        rxFrameLen = 0;
+        if (rxOverflow) {
+            rxOverflow = 0;
+            ++frame_rx_errors;
+            return XST_FAILURE;
+        }
+
+        len = FRAME_cobsDecode(rxFrame, len, rxDecoded);
+        if (FRAME_unpack(rxDecoded, len, pkt) != XST_SUCCESS) {
+            ++frame_rx_errors;
+            return XST_FAILURE;
+        }
+
+        ++frame_rx_count;
+        return XST_SUCCESS;
+    }
+}
+
+// One uart_write per frame, so frames from different tasks never interleave
+void FRAME_send(u8 cmd, u8 status, u16 id, const void *payload, u16 len) {
+    u8 wire[FRAME_MAX_WIRE];
+    size_t wireLen;
+
+    wireLen = FRAME_pack(wire, cmd, status, id, payload, len);
+    if (wireLen > 0) uart_write(wire, wireLen);
+}
+#endif
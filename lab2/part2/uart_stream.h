@@ -0,0 +1,63 @@
+/*
+ * uart_stream.h
+ *
+ * Interrupt-driven PS UART for the lab2 command line interfaces. The UART
+ * interrupt drains the whole RX FIFO into a FreeRTOS stream buffer, so tasks
+ * block on the buffer instead of polling the FIFO. Transmit goes the other
+ * way: writers copy into a TX stream buffer and the TX-empty interrupt
+ * refills the hardware FIFO from it, a full FIFO at a time.
+ */
+
+#ifndef UART_STREAM_H_
+#define UART_STREAM_H_
+
+#include "uart_config.h"
+#include "xil_types.h"
+#include "xparameters.h"
+#include "xscugic.h"
+#include "xuartps.h"
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "stream_buffer.h"
+
+#include <stddef.h>
+
+// Macros
+#define UART_BASEADDR      XPAR_UART1_BASEADDR
+#define UART_INT_IRQ_ID    XPS_UART1_INT_ID
+#define UART_BAUD_RATE     115200 // At start up, uart_set_baud() changes it
+#define UART_USE_XONXOFF   1      // XOFF when the RX buffer is 3/4 full
+#define UART_FIFO_DEPTH    64
+#define UART_RX_BUFFER_LEN 1024 // Stream buffer between the RX ISR and tasks
+#define UART_RX_TRIGGER    32   // RX FIFO level that raises an interrupt
+#define UART_RX_TIMEOUT    8    // Idle time, in 4 bit periods, before the
+                                // remaining bytes are flushed
+#define UART_TX_BUFFER_LEN 2048 // Stream buffer between writers and the TX ISR
+#define UART_TX_CHUNK      (UART_TX_BUFFER_LEN / 4) // Largest single copy
+
+// External variable declarations
+extern XUartPs UartPs;
+
+// Link state and statistics
+extern UartBaudInfo uart_baud;
+extern UartFlowControl uart_flow;
+extern UartErrorCounts uart_errors;
+extern volatile u32 uart_rx_irq_count;
+extern volatile u32 uart_rx_dropped; // Bytes lost to a full stream buffer
+extern volatile u32 uart_tx_irq_count;
+
+// Function prototypes
+int uart_init(void);
+int uart_start(XScuGic *IntcInstancePtr);
+int uart_set_baud(u32 baud);
+size_t uart_read(void *buf, size_t len, TickType_t timeout);
+size_t uart_peek(const u8 **data, TickType_t timeout);
+void uart_consume(size_t len);
+void uart_set_xonxoff(u8 enabled);
+void uart_flush_rx(void);
+void uart_write(const void *buf, size_t len);
+void uart_interrupt_handler(void *CallBackRef);
+
+#endif /* UART_STREAM_H_ */
@@ -41,6 +41,7 @@
 
 // UART driver header file
 #include "uart_driver.h"
+#include "ssd_driver.h"
 
 // Devices
 #define SSD_DEVICE_ID   XPAR_GPIO_SSD_BASEADDR
@@ -48,7 +49,6 @@
 #define LEDS_DEVICE_ID	XPAR_GPIO_LEDS_BASEADDR
 
 // Device channels
-#define SSD_CHANNEL		1
 #define BTN_CHANNEL		1
 
 // Other Useful Macros
@@ -59,11 +59,12 @@
 #define CHAR_ESC				0x23	// '#' character is used as termination sequence
 #define CHAR_CARRIAGE_RETURN	0x0D	// '\r' character is used in the termination sequence
 #define SEQUENCE_LENGTH 3 				//Rolling buffer sequence length
+#define BTN_POLL_MS 20					// Longest wait for UART data before the buttons are read again
 //#define configUSE_IDLE_HOOK 1
 
 
 // Device declaration
-XGpio SSDInst, btnInst, swInst, ledsInst;
+XGpio btnInst, swInst, ledsInst;
 
 
 // Function prototypes
@@ -74,7 +75,6 @@ void vBufferSendTask(void *p);
 u8 checkBufferSequence(u8 rollingBuffer[], char* sequence);
 void updateRollingBuffer(u8 rollingBuffer[], u8 receivedByte);
 
-u32 sevenSegDecode(int digit, u8 cathode);
 
 
 TaskHandle_t task_receiveuarthandle = NULL;
@@ -86,11 +86,7 @@ int main()
 	int status;
 
 	// SSD
-	status = XGpio_Initialize(&SSDInst, SSD_DEVICE_ID);
-	if(status != XST_SUCCESS){
-		xil_printf("GPIO Initialization for SSD failed.\r\n");
-		return XST_FAILURE;
-	}
+	SSD_begin(SSD_DEVICE_ID);
 
 	// Buttons
 	status = XGpio_Initialize(&btnInst, BTN_DEVICE_ID);
@@ -117,10 +113,13 @@ int main()
     status = initializeUART();
 	if (status != XST_SUCCESS){
 		xil_printf("UART Initialization failed\n");
+	} else {
+		char baudLine[96];
+		UART_formatBaud(baudLine, sizeof(baudLine), &uartBaud);
+		xil_printf("%s", baudLine);
 	}
 
 	// Device data direction: 0 for output 1 for input
-	XGpio_SetDataDirection(&SSDInst, SSD_CHANNEL, 0x00);
 	XGpio_SetDataDirection(&btnInst, BTN_CHANNEL, 0x0F);
 	XGpio_SetDataDirection(&ledsInst, 1, 0x00);
 	XGpio_SetDataDirection(&swInst, 2, 0x00);
@@ -144,16 +143,9 @@ int main()
 			   , &task_transmituarthandle
 			   );
 
-    // Queues
-	xTxQueue = xQueueCreate( SIZE_OF_QUEUE, sizeof(u8));
-	xRxQueue = xQueueCreate( SIZE_OF_QUEUE, sizeof(u8));
-
-    // assertions
+    // assertions, UART data goes through the driver's RX and TX rings
     configASSERT(vBufferReceiveTask);
     configASSERT(vBufferSendTask);
-    configASSERT(xTxQueue);
-	configASSERT(xTxQueue);
-	configASSERT(xRxQueue);
 
     // initializing globals
     countRxIrq = 0;
@@ -167,6 +159,7 @@ int main()
 	    "  (Numbers/symbols unchanged).\n"
 	    "- To view interrupt count, type: '\\r#\\r'\n"
 	    "- To reset interrupt count, type: '\\r%\\r'\n"
+	    "- To toggle the adaptive RX trigger, type: '\\r@\\r'\n"
 	    "- BTN0: Display Rx interrupt count on SSD.\n"
 	    "- BTN1: Display Tx interrupt count on SSD.\n"
 		"- BTN2: Display byte count on SSD.\n"
@@ -186,11 +179,14 @@ int main()
 void vBufferReceiveTask(void *p)
 {
     int status;
-    u8 pcString, cathode = 0;
+    u8 pcString;
+    u8 rxChunk[64];
+    size_t rxCount, i;
     char formattedChar;
-    u32 ssd_value = 1;
+    int ssdCount = 0;
     unsigned int sendMethod = 0, swVal, buttonVal = 0;
     u8 rollingBuffer[SEQUENCE_LENGTH] = {0, 0, 0};
+    u8 rxTriggerMax = UART_RX_TRIGGER_MAX;
 
     /* Local transmit buffer for string mode */
     char txBuffer[128];
@@ -201,67 +197,82 @@ void vBufferReceiveTask(void *p)
         xil_printf("UART PS interrupt failed\n");
     }
 
+    // The SSD is refreshed from the TTC interrupt, this task only updates it
+    status = SSD_startRefresh(&InterruptController);
+    if (status != XST_SUCCESS){
+        xil_printf("SSD refresh timer setup failed\n");
+    }
+
     while (1)
     {
-        /* Wait until RX queue has data */
-        while (myReceiveData() == pdFALSE){
-            swVal = XGpio_DiscreteRead(&swInst, 2);
-            sendMethod = (swVal == 0) ? 0 : 1;
-
-            buttonVal = XGpio_DiscreteRead(&btnInst, 1);
-
-            if (buttonVal == BTN0){
-                ssd_value = sevenSegDecode(countRxIrq, cathode);
-            } else if (buttonVal == BTN1){
-                ssd_value = sevenSegDecode(countTxIrq, cathode);
-            } else if (buttonVal == BTN2){
-                ssd_value = sevenSegDecode(byteCount, cathode);
-            } else if (buttonVal == BTN3){
-                byteCount  = 0;
-                countRxIrq = 0;
-                countTxIrq = 0;
-                ssd_value  = sevenSegDecode(88, cathode);
-            } else{
-                ssd_value = sevenSegDecode(0, cathode);
-            }
-
-            XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, ssd_value);
-            cathode = !cathode;
-        }
-
-        pcString = myReceiveByte();
-        formattedChar = (char)pcString;
+        /* Wait for a burst of received bytes, or read the buttons on timeout */
+        rxCount = myReceiveBytes(rxChunk, sizeof(rxChunk), pdMS_TO_TICKS(BTN_POLL_MS));
 
-        if (formattedChar >= 'A' && formattedChar <= 'Z'){
-            formattedChar = tolower(formattedChar);
-        } else if (formattedChar >= 'a' && formattedChar <= 'z'){
-            formattedChar = toupper(formattedChar);
-        }            
+        swVal = XGpio_DiscreteRead(&swInst, 2);
+        sendMethod = (swVal == 0) ? 0 : 1;
 
-        updateRollingBuffer(rollingBuffer, pcString);
+        buttonVal = XGpio_DiscreteRead(&btnInst, 1);
 
-        if (checkBufferSequence(rollingBuffer, "\r#\r")){
-            taskYIELD();
-        } else if (checkBufferSequence(rollingBuffer, "\r%\r")){
-            xil_printf("Byte Count and interrupt counters reset\n\n");
+        if (buttonVal == BTN0){
+            ssdCount = countRxIrq;
+        } else if (buttonVal == BTN1){
+            ssdCount = countTxIrq;
+        } else if (buttonVal == BTN2){
+            ssdCount = byteCount;
+        } else if (buttonVal == BTN3){
             byteCount  = 0;
             countRxIrq = 0;
             countTxIrq = 0;
-        } else {
-            if (sendMethod == 0){
-                mySendByte((u8)formattedChar);
+            myResetRxStats();
+            ssdCount   = 88;
+        } else{
+            ssdCount = 0;
+        }
+
+        SSD_showDecimal(ssdCount);
+
+        for (i = 0; i < rxCount; i++)
+        {
+            pcString = rxChunk[i];
+            formattedChar = (char)pcString;
+
+            if (formattedChar >= 'A' && formattedChar <= 'Z'){
+                formattedChar = tolower(formattedChar);
+            } else if (formattedChar >= 'a' && formattedChar <= 'z'){
+                formattedChar = toupper(formattedChar);
+            }
+
+            updateRollingBuffer(rollingBuffer, pcString);
+
+            if (checkBufferSequence(rollingBuffer, "\r#\r")){
+                taskYIELD();
+            } else if (checkBufferSequence(rollingBuffer, "\r%\r")){
+                xil_printf("Byte Count and interrupt counters reset\n\n");
+                byteCount  = 0;
+                countRxIrq = 0;
+                countTxIrq = 0;
+                myResetRxStats();
+            } else if (checkBufferSequence(rollingBuffer, "\r@\r")){
+                // Trade interrupt rate against latency
+                rxTriggerMax = (rxTriggerMax == 1) ? UART_RX_TRIGGER_MAX : 1;
+                mySetRxTriggerMax(rxTriggerMax);
+                xil_printf("RX trigger limit set to %d\n\n", rxTriggerMax);
             } else {
-                if (formattedChar != '\r'){
-                    if (txIndex < sizeof(txBuffer) - 1){
-                        txBuffer[txIndex++] = formattedChar;
-                    }
+                if (sendMethod == 0){
+                    mySendByte((u8)formattedChar);
                 } else {
-                    txBuffer[txIndex++] = '\r';
-                    txBuffer[txIndex] = '\0';
+                    if (formattedChar != '\r'){
+                        if (txIndex < sizeof(txBuffer) - 1){
+                            txBuffer[txIndex++] = formattedChar;
+                        }
+                    } else {
+                        txBuffer[txIndex++] = '\r';
+                        txBuffer[txIndex] = '\0';
 
-                    mySendString(txBuffer);
+                        mySendString(txBuffer);
 
-                    txIndex = 0;
+                        txIndex = 0;
+                    }
                 }
             }
         }
@@ -282,14 +293,31 @@ void vBufferSendTask(void *p)
         sprintf(CountTxIrqArray, "%d", countTxIrq);
 
         // Build message
-        char message[256];
+        char message[512];
         sprintf(message,
             "\n\nBytes received:\t%s\n"
             "Rx interrupts:\t%s\n"
-            "Tx interrupts:\t%s\n\n",
+            "Tx interrupts:\t%s\n"
+            "Rx cost/byte:\t%lu ns\n"
+            "Rx bytes/irq:\t%lu.%lu\n"
+            "Rx trigger:\t%d\n"
+            "Rx latency:\t%lu us avg, %d us max\n"
+            "Rx errors:\t%lu overrun, %lu framing, %lu parity\n"
+            "Rx dropped:\t%d (XOFF sent %lu)\n\n",
             countArray,
             CountRxIrqArray,
-            CountTxIrqArray);
+            CountTxIrqArray,
+            (unsigned long)myRxCostPerByteNs(),
+            (unsigned long)(myRxBytesPerIrqX10() / 10),
+            (unsigned long)(myRxBytesPerIrqX10() % 10),
+            rxTriggerLevel,
+            (unsigned long)myRxLatencyAvgUs(),
+            rxLatencyMaxUs,
+            (unsigned long)uartErrors.overrun,
+            (unsigned long)uartErrors.framing,
+            (unsigned long)uartErrors.parity,
+            countRxDropped,
+            (unsigned long)rxFlow.xoffCount);
 
         mySendString(message);
 
@@ -324,42 +352,3 @@ void updateRollingBuffer(u8 rollingBuffer[], u8 receivedByte)
 
     rollingBuffer[SEQUENCE_LENGTH - 1] = receivedByte;
 }
-
-
-// This function translates int values to their binary representation
-u32 sevenSegDecode(int countValue, u8 cathode)
-{
-    u32 result;
-    int digit;
-
-    // Convert countValue to two decimal digits
-    if (cathode == 0) {
-        // LSD: the least significant digit
-        digit = countValue % 10;
-    } else {
-        // MSD: the most significant digit
-        digit = (countValue / 10) % 10;
-    }
-
-    // Map the digit to the corresponding 7-segment display encoding
-    switch(digit){
-        case 0: result = 0b00111111; break; // 0
-        case 1: result = 0b00110000; break; // 1
-        case 2: result = 0b01011011; break; // 2
-        case 3: result = 0b01111001; break; // 3
-        case 4: result = 0b01110100; break; // 4
-        case 5: result = 0b01101101; break; // 5
-        case 6: result = 0b01101111; break; // 6
-        case 7: result = 0b00111000; break; // 7
-        case 8: result = 0b01111111; break; // 8
-        case 9: result = 0b01111100; break; // 9
-        default: result = 0b00000000; break; // Undefined, all segments are OFF
-    }
-
-    // The cathode logic remains unchanged
-    if (cathode == 1) {
-        return result;
-    } else {
-        return result | 0b10000000;
-    }
-}
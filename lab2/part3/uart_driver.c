@@ -5,12 +5,36 @@
  * Modified by : Antonio Andara
  * Modified on : February 22, 2026
  * TXTRIG-based UART driver
+ *
+ * Received bytes go through a single-producer/single-consumer ring: the ISR
+ * is the only writer of rxHead and the reading task the only writer of
+ * rxTail, so neither side needs a lock or a kernel queue call per byte. The
+ * reader is only woken once UART_RX_WAKE_LEVEL bytes are waiting or the
+ * receive timeout reports an idle line.
+ *
+ * The RX FIFO trigger level adapts to the traffic: it doubles, up to
+ * rxTriggerMax, each time a trigger interrupt finds the FIFO at the level,
+ * and halves when the receive timeout flushes a burst shorter than half of
+ * it. A higher level means fewer interrupts but a longer wait in the FIFO,
+ * so the estimated wait of the oldest byte is recorded for every interrupt.
+ * mySetRxTriggerMax(1) pins the level to one byte for the lowest latency.
+ *
+ * With UART_USE_XONXOFF the ring sends XOFF at three quarters full and XON
+ * once the reader has drained it to a quarter, so a bulk sender pauses
+ * instead of overflowing the ring.
+ *
+ * Transmit uses a second ring the other way round. Writers copy a whole
+ * buffer in under one critical section and, if the transmitter is idle,
+ * prime the FIFO themselves and enable TXEMPTY; from then on the TX ISR
+ * refills the FIFO until the ring is empty and disables TXEMPTY again.
  */
 
 #include "uart_driver.h"
 #include "task.h"
+#include "xtime_l.h"
 #include "xuartps.h"
 #include <portmacro.h>
+#include <string.h>
 #include <xil_printf.h>
 
 // -------------------------------------------------
@@ -21,52 +45,153 @@ XUartPs_Config *Config;
 INTC InterruptController;
 u32 IntrMask;
 
-// Queues
-QueueHandle_t xTxQueue;
-QueueHandle_t xRxQueue;
+UartBaudInfo uartBaud;
+UartFlowControl rxFlow;
+UartErrorCounts uartErrors;
 
 // Interrupt counters
 int countRxIrq;
 int countTxIrq;
 int byteCount;
+int countRxBytes;
+int countRxDropped;
+volatile int rxTriggerLevel = 1;
+volatile int rxLatencyMaxUs;
+
+// RX ring, indices run freely and are masked on access
+static u8 rxRing[UART_RX_RING_SIZE];
+static u32 rxHead;                     // Written by the ISR only
+static u32 rxTail;                     // Written by the reader only
+static TaskHandle_t volatile rxWaiter; // Reader blocked in myReceiveBytes
+
+// TX ring, txHead is advanced by writers inside a critical section
+static u8 txRing[UART_TX_RING_SIZE];
+static u32 txHead;
+static u32 txTail; // Advanced by the ISR, or a writer priming the FIFO
+
+// Time spent moving received bytes, in global timer counts
+static XTime rxIsrTime;
+static XTime rxTaskTime;
+
+// Adaptive RX trigger
+static volatile u32 rxTriggerMax = UART_RX_TRIGGER_MAX;
+static u32 rxCharNs;    // One 10-bit character at the current baud rate
+static u32 rxTimeoutNs; // Programmed receive timeout
+static u64 rxLatencySumNs;
+static u32 rxLatencySamples;
 
 // -------------------------------------------------
 // Interrupt Handler
 // -------------------------------------------------
-void interruptHandler(void *CallBackRef, u32 event, unsigned int EventData) {
+void interruptHandler(void *CallBackRef) {
     u32 isrStatus;
 
-    isrStatus = XUartPs_ReadReg(UART_BASEADDR, XUARTPS_ISR_OFFSET);
+    (void)CallBackRef;
+
+    isrStatus = XUartPs_ReadReg(UART_BASEADDR, XUARTPS_ISR_OFFSET) &
+                XUartPs_ReadReg(UART_BASEADDR, XUARTPS_IMR_OFFSET);
+
+    // Clear interrupts before handling, so events raised meanwhile are kept
+    XUartPs_WriteReg(UART_BASEADDR, XUARTPS_ISR_OFFSET, isrStatus);
+
+    if (isrStatus & UART_ERROR_MASK) {
+        UART_countErrors(isrStatus, &uartErrors);
+    }
 
     // RX events
-    if (isrStatus & (XUARTPS_IXR_RXFULL | XUARTPS_IXR_RXOVR)) {
-        handleReceiveEvent();
+    if (isrStatus &
+        (XUARTPS_IXR_RXFULL | XUARTPS_IXR_RXOVR | XUARTPS_IXR_TOUT)) {
+        handleReceiveEvent(isrStatus);
     }
 
     // TX EMPTY event
     if (isrStatus & XUARTPS_IXR_TXEMPTY) {
         handleSentEvent();
     }
-
-    // Clear interrupts
-    XUartPs_WriteReg(UART_BASEADDR, XUARTPS_ISR_OFFSET, isrStatus);
 }
 
 // -------------------------------------------------
 // RX ISR
 // -------------------------------------------------
-void handleReceiveEvent() {
-    u8 receive_buffer;
+// Called from the ISR with the number of bytes one interrupt drained
+static void adaptRxTrigger(u32 isrStatus, u32 fifoCount) {
+    u32 level = rxTriggerLevel;
+    u32 waitNs;
+
+    if (fifoCount == 0) return;
+
+    // The oldest byte waited for the rest to arrive, plus the idle timeout
+    waitNs = (fifoCount - 1) * rxCharNs;
+    if (isrStatus & XUARTPS_IXR_TOUT) waitNs += rxTimeoutNs;
+
+    rxLatencySumNs += waitNs;
+    ++rxLatencySamples;
+    if ((int)(waitNs / 1000) > rxLatencyMaxUs) rxLatencyMaxUs = waitNs / 1000;
+
+    if ((isrStatus & XUARTPS_IXR_RXOVR) && fifoCount >= level) {
+        level *= 2; // Heavy traffic, take more bytes per interrupt
+    } else if ((isrStatus & XUARTPS_IXR_TOUT) && fifoCount < level / 2) {
+        level /= 2; // Short bursts, stop waiting on the timeout
+    }
+
+    if (level > rxTriggerMax) level = rxTriggerMax;
+    if (level < 1) level = 1;
+
+    if (level != (u32)rxTriggerLevel) {
+        rxTriggerLevel = level;
+        XUartPs_WriteReg(UART_BASEADDR, XUARTPS_RXWM_OFFSET, level);
+    }
+}
+
+void handleReceiveEvent(u32 isrStatus) {
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    TaskHandle_t waiter;
+    XTime start, end;
+    u32 head, tail, fifoCount = 0;
+    u8 data;
 
+    XTime_GetTime(&start);
     ++countRxIrq;
 
+    head = rxHead;
+    tail = __atomic_load_n(&rxTail, __ATOMIC_ACQUIRE);
+
     while (XUartPs_IsReceiveData(UART_BASEADDR)) {
-        receive_buffer = XUartPs_ReadReg(UART_BASEADDR, UART_FIFO_OFFSET);
+        data = XUartPs_ReadReg(UART_BASEADDR, UART_FIFO_OFFSET);
+        ++fifoCount;
+
+        if (head - tail == UART_RX_RING_SIZE) {
+            ++countRxDropped;
+            continue;
+        }
+        rxRing[head & (UART_RX_RING_SIZE - 1)] = data;
+        ++head;
+    }
 
-        xQueueSendFromISR(xRxQueue, &receive_buffer, &xHigherPriorityTaskWoken);
+    // Publish the bytes only after they are in the ring
+    countRxBytes += head - rxHead;
+    __atomic_store_n(&rxHead, head, __ATOMIC_RELEASE);
+
+    UART_flowUpdate(UART_BASEADDR, &rxFlow, head - tail);
+
+    if (isrStatus & XUARTPS_IXR_TOUT) {
+        // Re-arm the receive timeout for the next burst
+        XUartPs_WriteReg(UART_BASEADDR, XUARTPS_CR_OFFSET,
+                         XUartPs_ReadReg(UART_BASEADDR, XUARTPS_CR_OFFSET) |
+                             XUARTPS_CR_TORST);
     }
 
+    adaptRxTrigger(isrStatus, fifoCount);
+
+    waiter = rxWaiter;
+    if (waiter != NULL && (head - tail >= UART_RX_WAKE_LEVEL ||
+                           (isrStatus & XUARTPS_IXR_TOUT))) {
+        vTaskNotifyGiveFromISR(waiter, &xHigherPriorityTaskWoken);
+    }
+
+    XTime_GetTime(&end);
+    rxIsrTime += end - start;
+
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
@@ -74,26 +199,29 @@ void handleReceiveEvent() {
 // TX ISR
 // -------------------------------------------------
 void handleSentEvent(void) {
-    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-    u8 txByte;
+    u32 head, tail, count;
 
     ++countTxIrq;
 
-    // Fill FIFO while not full and queue has data
-    while (!(XUartPs_ReadReg(UART.Config.BaseAddress, XUARTPS_SR_OFFSET) &
-             XUARTPS_SR_TXFULL)) {
-        if (xQueueReceiveFromISR(xTxQueue, &txByte,
-                                 &xHigherPriorityTaskWoken) == pdPASS) {
-            XUartPs_WriteReg(UART.Config.BaseAddress, XUARTPS_FIFO_OFFSET,
-                             txByte);
-        } else {
-            // No more data → disable TXEMPTY interrupt
-            disableTxEmpty();
-            break;
-        }
+    head  = __atomic_load_n(&txHead, __ATOMIC_ACQUIRE);
+    tail  = txTail;
+    count = head - tail;
+
+    if (count == 0) {
+        // No more data → disable TXEMPTY interrupt
+        disableTxEmpty();
+        return;
     }
 
-    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    // TXEMPTY means the FIFO is free, no need to poll TXFULL. One slot is
+    // left for an XON/XOFF the RX path may have written in this interrupt.
+    if (count > UART_FIFO_DEPTH - 1) count = UART_FIFO_DEPTH - 1;
+    for (; count > 0; --count, ++tail) {
+        XUartPs_WriteReg(UART_BASEADDR, UART_FIFO_OFFSET,
+                         txRing[tail & (UART_TX_RING_SIZE - 1)]);
+    }
+
+    __atomic_store_n(&txTail, tail, __ATOMIC_RELEASE);
 }
 
 // -------------------------------------------------
@@ -109,50 +237,223 @@ void disableTxEmpty(void) {
     XUartPs_SetInterruptMask(&UART, IntrMask);
 }
 
+// -------------------------------------------------
+// RX ring reader
+// -------------------------------------------------
+static size_t readRing(u8 *buf, size_t max) {
+    XTime start, end;
+    u32 head, tail, offset, first;
+    size_t count;
+
+    XTime_GetTime(&start);
+
+    tail  = rxTail;
+    head  = __atomic_load_n(&rxHead, __ATOMIC_ACQUIRE);
+    count = head - tail;
+    if (count > max) count = max;
+    if (count == 0) return 0;
+
+    // At most two copies, the second one when the data wraps
+    offset = tail & (UART_RX_RING_SIZE - 1);
+    first  = UART_RX_RING_SIZE - offset;
+    if (first > count) first = count;
+    memcpy(buf, &rxRing[offset], first);
+    memcpy(buf + first, rxRing, count - first);
+
+    // Hand the slots back to the ISR only after they were copied
+    __atomic_store_n(&rxTail, tail + count, __ATOMIC_RELEASE);
+    byteCount += count;
+
+    if (rxFlow.stopped) {
+        taskENTER_CRITICAL();
+        UART_flowUpdate(UART_BASEADDR, &rxFlow, rxHead - rxTail);
+        taskEXIT_CRITICAL();
+    }
+
+    XTime_GetTime(&end);
+    rxTaskTime += end - start;
+
+    return count;
+}
+
 // -------------------------------------------------
 // Public API
 // -------------------------------------------------
 BaseType_t myReceiveData(void) {
-    return (uxQueueMessagesWaiting(xRxQueue) > 0);
+    return (__atomic_load_n(&rxHead, __ATOMIC_ACQUIRE) != rxTail);
 }
 
 BaseType_t myTransmitFull(void) {
-    return (uxQueueSpacesAvailable(xTxQueue) == 0);
+    return (txHead - __atomic_load_n(&txTail, __ATOMIC_ACQUIRE) ==
+            UART_TX_RING_SIZE);
+}
+
+void mySendByte(u8 data) { mySendBytes(&data, 1); }
+
+u8 myReceiveByte(void) {
+    u8 buf;
+    myReceiveBytes(&buf, 1, portMAX_DELAY);
+    return buf;
+}
+
+// Copies up to max received bytes into buf. Blocks until at least one byte
+// is available or the timeout expires, and returns the number copied.
+size_t myReceiveBytes(u8 *buf, size_t max, TickType_t timeout) {
+    TimeOut_t timeOut;
+    size_t count;
+
+    vTaskSetTimeOutState(&timeOut);
+
+    // Registered before the first check, so bytes arriving between the check
+    // and the wait leave a pending notification instead of being missed
+    rxWaiter = xTaskGetCurrentTaskHandle();
+    while ((count = readRing(buf, max)) == 0) {
+        if (xTaskCheckForTimeOut(&timeOut, &timeout) != pdFALSE) break;
+        ulTaskNotifyTake(pdTRUE, timeout);
+    }
+    rxWaiter = NULL;
+
+    return count;
+}
+
+// CPU time per received byte, ISR and reader together
+u32 myRxCostPerByteNs(void) {
+    XTime total;
+    u32 bytes;
+
+    taskENTER_CRITICAL();
+    total = rxIsrTime + rxTaskTime;
+    bytes = countRxBytes;
+    taskEXIT_CRITICAL();
+
+    if (bytes == 0) return 0;
+    return (u32)((total * 1000000000ULL / COUNTS_PER_SECOND) / bytes);
+}
+
+// Average bytes drained per RX interrupt, in tenths
+u32 myRxBytesPerIrqX10(void) {
+    u32 bytes, irqs;
+
+    taskENTER_CRITICAL();
+    bytes = countRxBytes;
+    irqs  = rxLatencySamples;
+    taskEXIT_CRITICAL();
+
+    if (irqs == 0) return 0;
+    return bytes * 10 / irqs;
+}
+
+u32 myRxLatencyAvgUs(void) {
+    u64 sum;
+    u32 samples;
+
+    taskENTER_CRITICAL();
+    sum     = rxLatencySumNs;
+    samples = rxLatencySamples;
+    taskEXIT_CRITICAL();
+
+    if (samples == 0) return 0;
+    return (u32)(sum / samples / 1000);
 }
 
-void mySendByte(u8 data) {
+void myResetRxStats(void) {
+    taskENTER_CRITICAL();
+    rxIsrTime        = 0;
+    rxTaskTime       = 0;
+    countRxBytes     = 0;
+    rxLatencySumNs   = 0;
+    rxLatencySamples = 0;
+    rxLatencyMaxUs   = 0;
+    taskEXIT_CRITICAL();
+}
+
+// 1 turns the adaptation off and interrupts on every byte
+void mySetRxTriggerMax(u8 level) {
+    if (level < 1) level = 1;
+    if (level > UART_RX_TRIGGER_MAX) level = UART_RX_TRIGGER_MAX;
+
+    taskENTER_CRITICAL();
+    rxTriggerMax = level;
+    if ((u32)rxTriggerLevel > rxTriggerMax) {
+        rxTriggerLevel = rxTriggerMax;
+        XUartPs_WriteReg(UART_BASEADDR, XUARTPS_RXWM_OFFSET, rxTriggerLevel);
+    }
+    taskEXIT_CRITICAL();
+}
+
+// Copies as much of buf as fits into the TX ring and starts the
+// transmitter if it is idle. Returns the number of bytes taken.
+static size_t queueTx(const u8 *buf, size_t len) {
+    u32 head, tail, offset, first;
+    size_t count;
+
+    // Also keeps the TX ISR out, so the ring and IntrMask are ours here
     taskENTER_CRITICAL();
 
-    if (uxQueueMessagesWaiting(xTxQueue) == 0) {
-        XUartPs_WriteReg(UART.Config.BaseAddress, XUARTPS_FIFO_OFFSET, data);
+    head  = txHead;
+    tail  = txTail;
+    count = UART_TX_RING_SIZE - (head - tail);
+    if (count > len) count = len;
+
+    offset = head & (UART_TX_RING_SIZE - 1);
+    first  = UART_TX_RING_SIZE - offset;
+    if (first > count) first = count;
+    memcpy(&txRing[offset], buf, first);
+    memcpy(txRing, buf + first, count - first);
+    head += count;
+    __atomic_store_n(&txHead, head, __ATOMIC_RELEASE);
+
+    if (!(IntrMask & XUARTPS_IXR_TXEMPTY) && head != tail) {
+        // Transmitter idle: prime the FIFO, then let TXEMPTY take over
+        while (tail != head && !XUartPs_IsTransmitFull(UART_BASEADDR)) {
+            XUartPs_WriteReg(UART_BASEADDR, UART_FIFO_OFFSET,
+                             txRing[tail & (UART_TX_RING_SIZE - 1)]);
+            ++tail;
+        }
+        __atomic_store_n(&txTail, tail, __ATOMIC_RELEASE);
+
+        // Drop a stale TXEMPTY event, the FIFO is not empty now
+        XUartPs_WriteReg(UART_BASEADDR, XUARTPS_ISR_OFFSET,
+                         XUARTPS_IXR_TXEMPTY);
         enableTxEmpty();
-    } else {
-        xQueueSend(xTxQueue, &data, 0);
     }
+
     taskEXIT_CRITICAL();
+
+    return count;
 }
 
-u8 myReceiveByte(void) {
-    u8 buf;
-    xQueueReceive(xRxQueue, &buf, portMAX_DELAY);
-    ++byteCount;
-    return buf;
+// Waits a tick at a time while the TX ring is full
+void mySendBytes(const u8 *buf, size_t len) {
+    size_t sent;
+
+    while (len > 0) {
+        sent = queueTx(buf, len);
+        buf += sent;
+        len -= sent;
+        if (len > 0) vTaskDelay(1);
+    }
 }
 
 void mySendString(const char *str) {
     if (str == NULL) return;
-    for (; *str != '\0'; ++str) {
-        mySendByte(*str);
-    }
+    mySendBytes((const u8 *)str, strlen(str));
 }
 
 // -------------------------------------------------
 // Initialization
 // -------------------------------------------------
+
+// Start, stop and 8 data bits per character, the timeout counts 4 bits
+static void updateRxTiming(u32 baud) {
+    rxCharNs    = 10ULL * 1000000000ULL / baud;
+    rxTimeoutNs = UART_RX_TIMEOUT * 4ULL * 1000000000ULL / baud;
+}
+
 int initializeUART(void) {
     int Status;
 
-    Config = XUartPs_LookupConfig(UART_DEVICE_ID);
+    Config = XUartPs_LookupConfig(UART_BASEADDR);
     if (NULL == Config) {
         return XST_FAILURE;
     }
@@ -162,9 +463,41 @@ int initializeUART(void) {
         return XST_FAILURE;
     }
 
+    Status = UART_setBaud(&UART, UART_BAUD_RATE, &uartBaud);
+    if (Status != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+    updateRxTiming(uartBaud.actual);
+
+    UART_flowInit(&rxFlow, UART_RX_RING_SIZE, UART_USE_XONXOFF);
+
     return XST_SUCCESS;
 }
 
+// Waits for the TX ring and FIFO to drain at the old rate, then switches.
+// The result, including the divisor error, is left in uartBaud.
+int mySetBaudRate(u32 baud) {
+    UartBaudInfo info;
+    int Status;
+
+    if (UART_calcBaud(UART.Config.InputClockHz, baud, &info) != XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    while (txHead != __atomic_load_n(&txTail, __ATOMIC_ACQUIRE) ||
+           !(XUartPs_ReadReg(UART_BASEADDR, XUARTPS_SR_OFFSET) &
+             XUARTPS_SR_TXEMPTY)) {
+        vTaskDelay(1);
+    }
+
+    taskENTER_CRITICAL();
+    Status = UART_setBaud(&UART, baud, &uartBaud);
+    if (Status == XST_SUCCESS) updateRxTiming(uartBaud.actual);
+    taskEXIT_CRITICAL();
+
+    return Status;
+}
+
 int setupInterruptSystem(INTC *IntcInstancePtr, XUartPs *UartInstancePtr,
                          u16 UartIntrId) {
     int Status;
@@ -181,27 +514,28 @@ int setupInterruptSystem(INTC *IntcInstancePtr, XUartPs *UartInstancePtr,
                                  (Xil_ExceptionHandler)XScuGic_InterruptHandler,
                                  IntcInstancePtr);
 
+    // Connected directly, the generic XUartPs_InterruptHandler dispatch adds
+    // a second status read and callback per interrupt
     Status = XScuGic_Connect(IntcInstancePtr, UartIntrId,
-                             (Xil_ExceptionHandler)XUartPs_InterruptHandler,
+                             (Xil_ExceptionHandler)interruptHandler,
                              (void *)UartInstancePtr);
     if (Status != XST_SUCCESS) return XST_FAILURE;
 
     XScuGic_Enable(IntcInstancePtr, UartIntrId);
     Xil_ExceptionEnable();
 
-    XUartPs_SetHandler(UartInstancePtr, (XUartPs_Handler)interruptHandler,
-                       UartInstancePtr);
-
     // -------------------------------------------------
     // IMPORTANT: RX FIFO trigger level
     // -------------------------------------------------
-    XUartPs_SetFifoThreshold(UartInstancePtr,
-                             1); // interrupt triggers when FIFO <= 1
+    // Starts at one byte, adaptRxTrigger() raises it under load
+    rxTriggerLevel = 1;
+    XUartPs_SetFifoThreshold(UartInstancePtr, rxTriggerLevel);
+    XUartPs_SetRecvTimeout(UartInstancePtr, UART_RX_TIMEOUT);
 
     // UART interrupt mask, Enable the interrupt when the receive buffer has
     // reached a particular threshold
     IntrMask = XUARTPS_IXR_TOUT | XUARTPS_IXR_RXFULL | XUARTPS_IXR_RXOVR |
-               XUARTPS_IXR_TXEMPTY;
+               XUARTPS_IXR_TXEMPTY | UART_ERROR_MASK;
 
     XUartPs_SetInterruptMask(UartInstancePtr, IntrMask);
     XUartPs_SetOperMode(UartInstancePtr, XUARTPS_OPER_MODE_NORMAL);
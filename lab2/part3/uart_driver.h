@@ -10,6 +10,7 @@
 #ifndef UART_DRIVER_H_
 #define UART_DRIVER_H_
 
+#include "uart_config.h"
 #include "xil_io.h"
 #include "xuartps.h" // UART definitions header file
 #include "xscugic.h" // Interrupt controller header file
@@ -20,6 +21,8 @@
 #include "task.h"
 #include "queue.h"
 
+#include <stddef.h>
+
 // Macros
 #define INTC               	XScuGic
 #define UART_DEVICE_ID     	0
@@ -28,42 +31,70 @@
 #define UART_BASEADDR       XPAR_UART1_BASEADDR
 #define UART_FIFO_OFFSET    XUARTPS_FIFO_OFFSET
 #define UART_RX_BUFFER_SIZE 3U
+#define UART_BAUD_RATE      115200 // At start up, mySetBaudRate() changes it
+#define UART_USE_XONXOFF    1      // XOFF when the RX ring is 3/4 full
+#define UART_RX_RING_SIZE   1024U // Must be a power of two
+#define UART_RX_WAKE_LEVEL  32U   // Ring fill that wakes the reader early
+#define UART_RX_TIMEOUT     8U    // Idle time, in 4 bit periods, before the
+                                  // reader is woken for a partial message
 #define RECEIVED_DATA       XUARTPS_EVENT_RECV_DATA
 #define SENT_DATA           XUARTPS_EVENT_SENT_DATA
-#define SIZE_OF_QUEUE      	100
+#define UART_TX_RING_SIZE   1024U // Must be a power of two
+#define UART_FIFO_DEPTH     64U
+#define UART_RX_TRIGGER_MAX 63U   // Highest RX FIFO trigger level (6 bits)
 
 #define SEND_TO_QUEUE 0
 #define SEND_DIRECT   1
 
+#if (UART_RX_RING_SIZE & (UART_RX_RING_SIZE - 1)) != 0
+#error "UART_RX_RING_SIZE must be a power of two"
+#endif
+#if (UART_TX_RING_SIZE & (UART_TX_RING_SIZE - 1)) != 0
+#error "UART_TX_RING_SIZE must be a power of two"
+#endif
+
 // External variable declarations
 extern XUartPs UART;
 extern XUartPs_Config *Config;
 extern INTC InterruptController;
 extern u32 IntrMask;
 
-// Queues
-extern QueueHandle_t xTxQueue;
-extern QueueHandle_t xRxQueue;
+// Link state
+extern UartBaudInfo uartBaud;
+extern UartFlowControl rxFlow;
+extern UartErrorCounts uartErrors;
 
 // Interrupt counters
 extern int countRxIrq;
 extern int countTxIrq;
 extern int countSent;
 extern int byteCount;
+extern int countRxBytes;   // Bytes the ISR moved into the RX ring
+extern int countRxDropped; // Bytes lost to a full RX ring
+extern volatile int rxTriggerLevel; // Current RX FIFO trigger level
+extern volatile int rxLatencyMaxUs; // Longest estimated FIFO wait of a byte
 
 // Function prototypes
-void interruptHandler(void *CallBackRef, u32 Event, unsigned int EventData);
-void handleReceiveEvent();
+void interruptHandler(void *CallBackRef);
+void handleReceiveEvent(u32 isrStatus);
 void handleSentEvent();
 void transmitDataFromQueue(u8 *data, BaseType_t *taskToSwitch);
 void disableTxEmpty();
 void enableTxEmpty();
 int initializeUART(void);
+int mySetBaudRate(u32 baud);
 int setupInterruptSystem(INTC *IntcInstancePtr, XUartPs *UartInstancePtr, u16 UartIntrId);
 BaseType_t myReceiveData(void);
 u8 myReceiveByte(void);
+size_t myReceiveBytes(u8 *buf, size_t max, TickType_t timeout);
+u32 myRxCostPerByteNs(void);
+u32 myRxBytesPerIrqX10(void);
+u32 myRxLatencyAvgUs(void);
+void myResetRxStats(void);
+void mySetRxTriggerMax(u8 level);
 BaseType_t myTransmitFull(void);
 void mySendByte(u8 Data);
+void mySendBytes(const u8 *buf, size_t len);
 void mySendString(const char *pString);
 
 #endif /* SRC_UART_DRIVER_H_ */
@@ -0,0 +1,23 @@
+/*
+ * dlog_formats.h
+ *
+ * Messages logged through DLOG() in this lab. Append new entries at the end,
+ * the position is the ID stored in each record, so reordering breaks the
+ * decoding of older dumps.
+ */
+
+#ifndef DLOG_FORMATS_H_
+#define DLOG_FORMATS_H_
+
+#define DLOG_FORMATS(X)                                                       \
+    X(LOG_UART_LOOPBACK_ON, "\r\n*** UART Loop-back ON ***\r\n")              \
+    X(LOG_UART_LOOPBACK_OFF, "\r\n*** UART Loop-back OFF ***\r\n")            \
+    X(LOG_SPI_LOOPBACK_ON, "\r\n*** SPI Loop-back ON ***\r\n")                \
+    X(LOG_SPI_LOOPBACK_OFF, "\r\n*** SPI Loop-back OFF ***\r\n")              \
+    X(LOG_INPUT_ENDED,                                                        \
+      "\r\n*** Text entry ended using termination sequence ***\r\n")          \
+    X(LOG_UART_ERRORS,                                                        \
+      "\r\n*** UART errors: overrun %u, framing %u, parity %u ***\r\n")       \
+    X(LOG_BAUD_FAILED, "\r\n*** Could not set %u baud ***\r\n")
+
+#endif /* DLOG_FORMATS_H_ */
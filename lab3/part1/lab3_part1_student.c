@@ -46,11 +46,13 @@
 /******************************************************************************/
 
 #include "FreeRTOS.h"
+#include "dlog.h"
 #include "my_spi.h"
 #include "my_uart.h"
 #include "portmacro.h"
 #include "projdefs.h"
 #include "queue.h"
+#include "semphr.h"
 #include "stdio.h"
 #include "string.h"
 #include "task.h"
@@ -91,6 +93,9 @@ static void updateRollingBuffer(u8 rolling[3], u8 byte);
 static BaseType_t terminationSequence(const u8 rolling[3]);
 static BaseType_t checkCommand(const u8 rolling[3]);
 static void terminateInput(void);
+static void reportUartErrors(void);
+static void logSink(const char *buf, size_t len);
+static void echoByte(u8 byte);
 
 /************************* Global Variables *********************************/
 static XGpio rgbLed;
@@ -98,6 +103,10 @@ static XGpio rgbLed;
 static QueueHandle_t uart_to_spi = NULL;
 static QueueHandle_t spi_to_uart = NULL;
 
+/* Held by the log task for a whole message and by echoByte(), so echoed
+ * characters never land in the middle of a status line */
+static SemaphoreHandle_t uart_tx_mutex = NULL;
+
 static volatile u8 uart_loopback = 0;
 static volatile u8 spi_loopback =
     0; /* 0: local SPI-main loopback 1: real main-sub loop */
@@ -108,6 +117,12 @@ static volatile int total_bytes_received_over_spi = 0;
 static volatile int last_message_byte_count       = 0;
 static volatile int total_messages_received       = 0;
 
+/* <ENTER>4<ENTER> steps through these, the terminal has to follow */
+static const u32 baud_rates[] = {UART_DEFAULT_BAUD, 230400, 460800,
+                                 UART_MAX_BAUD};
+static u32 baud_index         = 0;
+static u32 uart_errors_seen   = 0; /* Sum of the counts last reported */
+
 /******************************************************************************
 /* MAIN */
 /******************************************************************************/
@@ -137,14 +152,19 @@ int main(void) {
 
     uart_to_spi = xQueueCreate(QUEUE_LENGTH, sizeof(u8));
     spi_to_uart = xQueueCreate(QUEUE_LENGTH, sizeof(u8));
+    uart_tx_mutex = xSemaphoreCreateMutex();
 
     xTaskCreate(vUartManagerTask, "UART", 512, NULL, 2, NULL);
     xTaskCreate(vSpiMainTask, "SPI_MAIN", 512, NULL, 2, NULL);
     xTaskCreate(vSpiSubTask, "SPI_SUB", 512, NULL, 2, NULL);
     xTaskCreate(vRgbLedTask, "RGB", 256, NULL, 2, NULL);
 
+    // Status messages are printed below the lab tasks, when they all sleep
+    DLOG_start(logSink, 1);
+
     configASSERT(uart_to_spi);
     configASSERT(spi_to_uart);
+    configASSERT(uart_tx_mutex);
     configASSERT(vUartManagerTask);
     configASSERT(vSpiMainTask);
     configASSERT(vSpiSubTask);
@@ -177,7 +197,7 @@ static void vUartManagerTask(void *pvParameters) {
                 xQueueReceive(spi_to_uart, &spi_byte, portMAX_DELAY);
 
                 if (spi_byte != CHAR_DOLLAR) {
-                    uartWriteByte(spi_byte);
+                    echoByte(spi_byte);
                 } else {
                     break;
                 }
@@ -186,6 +206,9 @@ static void vUartManagerTask(void *pvParameters) {
             terminateInput();
         }
 
+        // The error bits latch in the status register, report new ones
+        reportUartErrors();
+
         if (uartReadByte(&uart_byte)) {
             updateRollingBuffer(rolling, uart_byte);
 
@@ -198,7 +221,7 @@ static void vUartManagerTask(void *pvParameters) {
 
             if (uart_loopback && command_flag == 1) {
                 // TODO 1: write to uart
-                uartWriteByte(uart_byte);
+                echoByte(uart_byte);
 
                 if (terminationSequence(rolling)) {
                     terminateInput();
@@ -215,7 +238,7 @@ static void vUartManagerTask(void *pvParameters) {
 
         while (xQueueReceive(spi_to_uart, &spi_byte, 0)) {
             if (spi_byte != CHAR_DOLLAR) {
-                uartWriteByte(spi_byte);
+                echoByte(spi_byte);
             }
         }
 
@@ -441,14 +464,16 @@ static BaseType_t terminationSequence(const u8 rolling[3]) {
 }
 
 static BaseType_t checkCommand(const u8 rolling[3]) {
+    int status;
+
     if ((rolling[0] == CHAR_CARRIAGE_RETURN) &&
         (rolling[2] == CHAR_CARRIAGE_RETURN)) {
         if (rolling[1] == '1') {
             uart_loopback = (uart_loopback == 0) ? 1 : 0;
             command_flag  = 1;
 
-            xil_printf("\r\n*** UART Loop-back %s ***\r\n",
-                       (uart_loopback == 1) ? "ON" : "OFF");
+            DLOG((uart_loopback == 1) ? LOG_UART_LOOPBACK_ON
+                                      : LOG_UART_LOOPBACK_OFF);
 
             return pdTRUE;
         }
@@ -457,8 +482,31 @@ static BaseType_t checkCommand(const u8 rolling[3]) {
             spi_loopback = (spi_loopback == 0) ? 1 : 0;
             command_flag = 2;
 
-            xil_printf("\r\n*** SPI Loop-back %s ***\r\n",
-                       (spi_loopback == 1) ? "ON" : "OFF");
+            DLOG((spi_loopback == 1) ? LOG_SPI_LOOPBACK_ON
+                                     : LOG_SPI_LOOPBACK_OFF);
+
+            return pdTRUE;
+        }
+
+        if (rolling[1] == '3') {
+            uart_errors_seen = ~0u; /* Forces a report even with no change */
+            reportUartErrors();
+
+            return pdTRUE;
+        }
+
+        if (rolling[1] == '4') {
+            baud_index = (baud_index + 1) % (sizeof(baud_rates) /
+                                             sizeof(baud_rates[0]));
+
+            // Not in the middle of a log message
+            xSemaphoreTake(uart_tx_mutex, portMAX_DELAY);
+            status = uartSetBaud(baud_rates[baud_index]);
+            xSemaphoreGive(uart_tx_mutex);
+
+            if (status != XST_SUCCESS) {
+                DLOG(LOG_BAUD_FAILED, baud_rates[baud_index]);
+            }
 
             return pdTRUE;
         }
@@ -473,7 +521,18 @@ static void terminateInput(void) {
     spi_loopback  = 0;
     uart_loopback = 0;
 
-    xil_printf("\r\n*** Text entry ended using termination sequence ***\r\n");
+    DLOG(LOG_INPUT_ENDED);
+}
+
+static void reportUartErrors(void) {
+    const UartErrorCounts *errors = uartGetErrors();
+    u32 total = errors->overrun + errors->framing + errors->parity;
+
+    if (total != uart_errors_seen) {
+        uart_errors_seen = total;
+        DLOG(LOG_UART_ERRORS, errors->overrun, errors->framing,
+             errors->parity);
+    }
 }
 
 static void printMenu(void) {
@@ -481,9 +540,28 @@ static void printMenu(void) {
         "\r\n================ ECE-315 Lab 3: UART + SPI =================\r\n");
     xil_printf("Commands: <ENTER>1<ENTER> toggles UART loopback mode\r\n");
     xil_printf("          <ENTER>2<ENTER> toggles SPI loopback mode\r\n");
+    xil_printf("          <ENTER>3<ENTER> shows the UART error counts\r\n");
+    xil_printf("          <ENTER>4<ENTER> steps the baud rate up to %d, "
+               "then back to %d\r\n",
+               UART_MAX_BAUD, UART_DEFAULT_BAUD);
     xil_printf("Termination sequence: <ENTER>%<ENTER>\r\n");
     xil_printf("\r\nModes:\r\n");
     xil_printf("  UART loopback ON   : UART echoes locally\r\n");
     xil_printf("  SPI loopback OFF   : SPI main echoes queue byte\r\n");
     xil_printf("  SPI loopback ON    : Real SPI0 -> SPI1 -> SPI0 loop\r\n");
 }
+
+/* Runs in the log task, the UART is polled so this waits on the TX FIFO */
+static void logSink(const char *buf, size_t len) {
+    xSemaphoreTake(uart_tx_mutex, portMAX_DELAY);
+    while (len-- > 0) {
+        uartWriteByte((u8)*buf++);
+    }
+    xSemaphoreGive(uart_tx_mutex);
+}
+
+static void echoByte(u8 byte) {
+    xSemaphoreTake(uart_tx_mutex, portMAX_DELAY);
+    uartWriteByte(byte);
+    xSemaphoreGive(uart_tx_mutex);
+}
@@ -5,6 +5,16 @@
 
 static XUartPs uartInst;
 static XUartPs_Config *uartCfg;
+static UartBaudInfo uartBaud;
+static UartErrorCounts uartErrors;
+
+static void uartPrintBaud(void)
+{
+	char line[96];
+
+	UART_formatBaud(line, sizeof(line), &uartBaud);
+	xil_printf("%s", line);
+}
 
 int uartInit(u32 BaseAddress)
 {
@@ -20,10 +30,45 @@ int uartInit(u32 BaseAddress)
 		return XST_FAILURE;
 	}
 
+	status = UART_setBaud(&uartInst, UART_DEFAULT_BAUD, &uartBaud);
+	if (status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
 	XUartPs_SetOperMode(&uartInst, XUARTPS_OPER_MODE_NORMAL);
+	uartPrintBaud();
+	return XST_SUCCESS;
+}
+
+/* Lets the transmitter drain at the old rate first, up to 921600 baud */
+int uartSetBaud(u32 baud)
+{
+	UartBaudInfo info;
+
+	if ((uartCfg == NULL) ||
+	    (UART_calcBaud(uartCfg->InputClockHz, baud, &info) != XST_SUCCESS)) {
+		return XST_FAILURE;
+	}
+
+	while (!(XUartPs_ReadReg(uartCfg->BaseAddress, XUARTPS_SR_OFFSET) &
+	         XUARTPS_SR_TXEMPTY));
+
+	if (UART_setBaud(&uartInst, baud, &uartBaud) != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	uartPrintBaud();
 	return XST_SUCCESS;
 }
 
+const UartErrorCounts *uartGetErrors(void)
+{
+	if (uartCfg != NULL) {
+		UART_pollErrors(uartCfg->BaseAddress, &uartErrors);
+	}
+	return &uartErrors;
+}
+
 int uartReadByte(u8 *outByte)
 {
 	if ((outByte == NULL) || (uartCfg == NULL)) {
@@ -32,6 +77,7 @@ int uartReadByte(u8 *outByte)
 
 	if (XUartPs_IsReceiveData(uartCfg->BaseAddress)) {
 		*outByte = XUartPs_ReadReg(uartCfg->BaseAddress, XUARTPS_FIFO_OFFSET);
+		UART_pollErrors(uartCfg->BaseAddress, &uartErrors);
 		return 1;
 	}
 
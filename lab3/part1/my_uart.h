@@ -1,10 +1,15 @@
 #ifndef SRC_MY_UART_H_
 #define SRC_MY_UART_H_
 
+#include "uart_config.h"
 #include "xil_types.h"
 #include "xstatus.h"
 
+#define UART_DEFAULT_BAUD 115200 // uartSetBaud() changes it at run time
+
 int uartInit(u32 BaseAddress);
+int uartSetBaud(u32 baud);
+const UartErrorCounts *uartGetErrors(void);
 int uartReadByte(u8 *outByte);
 void uartWriteByte(u8 byte);
 void uartPrintMenu(void);
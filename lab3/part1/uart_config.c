@@ -0,0 +1,138 @@
+/*
+ * uart_config.c
+ *
+ * The baud rate is InputClockHz / (CD * (BDIV + 1)). Every BDIV from 4 to 254
+ * is tried with the nearest CD and the pair with the smallest error wins,
+ * like XUartPs_SetBaudRate, but the result is kept so it can be reported.
+ */
+
+#include "uart_config.h"
+
+#include <stdio.h>
+
+// -------------------------------------------------
+// Baud rate
+// -------------------------------------------------
+int UART_calcBaud(u32 InputClockHz, u32 baud, UartBaudInfo *info) {
+    u32 bdiv, cd, actual, error;
+    u32 bestError = 0xFFFFFFFF;
+
+    if (baud == 0 || baud > UART_MAX_BAUD) return XST_FAILURE;
+
+    for (bdiv = 4; bdiv < 255; bdiv++) {
+        cd = (InputClockHz + baud * (bdiv + 1) / 2) / (baud * (bdiv + 1));
+        if (cd < 2 || cd > 0xFFFF) continue; // 0 stops the clock, 1 bypasses
+
+        actual = InputClockHz / (cd * (bdiv + 1));
+        error  = (actual > baud) ? actual - baud : baud - actual;
+        if (error < bestError) {
+            bestError    = error;
+            info->cd     = cd;
+            info->bdiv   = bdiv;
+            info->actual = actual;
+        }
+    }
+
+    if (bestError == 0xFFFFFFFF) return XST_FAILURE;
+
+    info->requested = baud;
+    info->errorPpm  = (s32)(((s64)info->actual - baud) * 1000000 / baud);
+
+    if (info->errorPpm > UART_MAX_BAUD_ERROR_PPM ||
+        info->errorPpm < -UART_MAX_BAUD_ERROR_PPM) {
+        return XST_FAILURE;
+    }
+
+    return XST_SUCCESS;
+}
+
+// Drops anything in the FIFOs, so wait for the transmitter to drain first
+int UART_setBaud(XUartPs *InstancePtr, u32 baud, UartBaudInfo *info) {
+    u32 base = InstancePtr->Config.BaseAddress;
+
+    if (UART_calcBaud(InstancePtr->Config.InputClockHz, baud, info) !=
+        XST_SUCCESS) {
+        return XST_FAILURE;
+    }
+
+    // Same sequence as XUartPs_SetBaudRate: disable, program, reset, enable
+    XUartPs_WriteReg(base, XUARTPS_CR_OFFSET,
+                     XUARTPS_CR_RX_DIS | XUARTPS_CR_TX_DIS);
+    XUartPs_WriteReg(base, XUARTPS_BAUDGEN_OFFSET, info->cd);
+    XUartPs_WriteReg(base, XUARTPS_BAUDDIV_OFFSET, info->bdiv);
+    XUartPs_WriteReg(base, XUARTPS_CR_OFFSET,
+                     XUARTPS_CR_TXRST | XUARTPS_CR_RXRST);
+    XUartPs_WriteReg(base, XUARTPS_CR_OFFSET,
+                     XUARTPS_CR_RX_EN | XUARTPS_CR_TX_EN);
+
+    InstancePtr->BaudRate = baud;
+
+    return XST_SUCCESS;
+}
+
+int UART_formatBaud(char *buf, size_t size, const UartBaudInfo *info) {
+    return snprintf(buf, size,
+                    "UART %lu baud: actual %lu, error %ld ppm (CD %u, BDIV %u)\n",
+                    (unsigned long)info->requested, (unsigned long)info->actual,
+                    (long)info->errorPpm, (unsigned)info->cd,
+                    (unsigned)info->bdiv);
+}
+
+// -------------------------------------------------
+// XON/XOFF
+// -------------------------------------------------
+
+// XOFF at three quarters full, XON again at one quarter. The quarter left
+// above the high mark covers the FIFO and the host's reaction time.
+void UART_flowInit(UartFlowControl *flow, u32 bufferSize, u8 enabled) {
+    flow->enabled   = enabled;
+    flow->stopped   = 0;
+    flow->highWater = bufferSize - bufferSize / 4;
+    flow->lowWater  = bufferSize / 4;
+    flow->xoffCount = 0;
+}
+
+// Call with the receive buffer level after it changes. The ISR and the
+// reader both update the state, so task callers hold a critical section.
+void UART_flowUpdate(u32 BaseAddress, UartFlowControl *flow, u32 level) {
+    u8 control;
+
+    if (!flow->enabled) return;
+
+    if (!flow->stopped && level >= flow->highWater) {
+        control       = UART_XOFF;
+        flow->stopped = 1;
+        ++flow->xoffCount;
+    } else if (flow->stopped && level <= flow->lowWater) {
+        control       = UART_XON;
+        flow->stopped = 0;
+    } else {
+        return;
+    }
+
+    while (XUartPs_IsTransmitFull(BaseAddress)) {
+    }
+    XUartPs_WriteReg(BaseAddress, XUARTPS_FIFO_OFFSET, control);
+}
+
+// -------------------------------------------------
+// Line errors
+// -------------------------------------------------
+void UART_countErrors(u32 isrStatus, UartErrorCounts *counts) {
+    if (isrStatus & XUARTPS_IXR_OVER) ++counts->overrun;
+    if (isrStatus & XUARTPS_IXR_FRAMING) ++counts->framing;
+    if (isrStatus & XUARTPS_IXR_PARITY) ++counts->parity;
+}
+
+// For polled drivers, the status bits latch even while the interrupts are
+// masked
+void UART_pollErrors(u32 BaseAddress, UartErrorCounts *counts) {
+    u32 isrStatus;
+
+    isrStatus = XUartPs_ReadReg(BaseAddress, XUARTPS_ISR_OFFSET) &
+                UART_ERROR_MASK;
+    if (isrStatus == 0) return;
+
+    XUartPs_WriteReg(BaseAddress, XUARTPS_ISR_OFFSET, isrStatus);
+    UART_countErrors(isrStatus, counts);
+}
@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <xstatus.h>
 #include "pmodkypd.h"
+#include "ssd_driver.h"
 #include "PmodOLED.h"
 #include "OLEDControllerCustom.h"
 
@@ -23,7 +24,6 @@
 #define KYPD_BASE_ADDR      XPAR_GPIO_KEYPAD_BASEADDR
 #define SSD_DEVICE_ID       XPAR_GPIO_SSD_BASEADDR
 #define BTN_CHANNEL         1
-#define SSD_CHANNEL         1
 
 
 #define FRAME_DELAY_MS      200
@@ -31,7 +31,6 @@
 
 #define DIR_QUEUE_LEN       4
 #define BTN_QUEUE_LEN       1
-#define SCORE_QUEUE_LEN     2
 
 // keypad key table
 #define DEFAULT_KEYTABLE    "0FED789C456B123A"
@@ -59,7 +58,6 @@ const char TIME_MESSAGE[] = "Time: %u";
 XGpio       btnInst;
 PmodOLED    oledDevice;
 PmodKYPD    KYPDInst;
-XGpio       SSDInst;
 
 typedef struct snake_block {
     struct snake_block *next; 
@@ -74,8 +72,6 @@ void initializeScreen();
 static void keypadTask( void *pvParameters );
 static void oledTask( void *pvParameters );
 static void buttonTask( void *pvParameters );
-static void ssdTask( void *pvParameters );
-static u32 SSD_decode(u8 key_value, u8 cathode);
 static snake_block *start_game(void);
 static snake_block *create_consumable(void);
 static void draw_snake(snake_block *block);
@@ -106,10 +102,12 @@ enum game_states {
     GAME_OVER = 4
 };
 
+// GIC instance set up by the FreeRTOS port when the scheduler starts
+extern XScuGic xInterruptController;
+
 // FreeRTOS queue handles
 QueueHandle_t xDirectionQueue;
 QueueHandle_t xButtonQueue;
-QueueHandle_t xScoreQueue;
 
 // Game values
 u8 score = 0;
@@ -119,11 +117,7 @@ int main() {
     InitializeKeypad();
 
     // initialize ssd
-    if (XGpio_Initialize(&SSDInst, SSD_DEVICE_ID) != XST_SUCCESS) {
-        xil_printf("GPIO initialization for SSD failed.\r\n");
-        return XST_FAILURE;
-    }
-    XGpio_SetDataDirection(&SSDInst, SSD_CHANNEL, 0x0);
+    SSD_begin(SSD_DEVICE_ID);
 
 
     // initialize oled
@@ -146,7 +140,6 @@ int main() {
     // ------------ Create Queues ------------
     xDirectionQueue = xQueueCreate(DIR_QUEUE_LEN, sizeof(u8));
     xButtonQueue    = xQueueCreate(BTN_QUEUE_LEN, sizeof(u8));
-    xScoreQueue     = xQueueCreate(SCORE_QUEUE_LEN, sizeof(u8));
 
     // ------------ Create Tasks ------------
     xTaskCreate( keypadTask                 /* The function that implements the task. */
@@ -174,14 +167,6 @@ int main() {
                , NULL
                );
 
-    xTaskCreate( ssdTask
-               , "ssd task"
-               , configMINIMAL_STACK_SIZE
-               , NULL
-               , tskIDLE_PRIORITY
-               , NULL
-    );
-
     vTaskStartScheduler();
 
     while(1); // shouldn't get here, hang system
@@ -200,34 +185,18 @@ void InitializeKeypad()
 static void keypadTask(void *pvParameters) {
     (void) pvParameters;
 
-    u16 keystate = 0;
-    u16 last_keystate = 0; 
-    XStatus status;
-    XStatus last_status = KYPD_NO_KEY;
-    u8 new_key = 0;
-    const TickType_t xDelay = pdMS_TO_TICKS(10);
+    KYPD_Event event;
 
     while (1) {
-        keystate = KYPD_getKeyStates(&KYPDInst);
-        status = KYPD_getKeyPressed(&KYPDInst, keystate, &new_key);
-
-        // detect if a new key is pressed (if status has changed)
-        if (status == KYPD_SINGLE_KEY && last_status == KYPD_NO_KEY) {
-            // update snake direction
-            xQueueSend(xDirectionQueue, &new_key, 0);
-        } else if (status == KYPD_MULTI_KEY && last_status == KYPD_SINGLE_KEY) {
-            // if new key and last keys pressed overlap
-            if ((keystate & last_keystate) != 0) {
-                // new keys take precedent
-                KYPD_getKeyPressed(&KYPDInst, (keystate & ~last_keystate), &new_key);
-                xQueueSend(xDirectionQueue, &new_key, 0);
-            }
+        // Block until the debounced keypad reports a change
+        KYPD_waitEvent(&KYPDInst, &event, portMAX_DELAY);
+
+        // every new press steers the snake, so a key pressed while another
+        // is still held takes precedence. Ignore presses that may be ghosts.
+        if (event.type == KYPD_EVENT_PRESS
+            && !KYPD_isGhosted(KYPD_getDebouncedKeyStates(&KYPDInst))) {
+            xQueueSend(xDirectionQueue, &event.key, 0);
         }
-
-        last_status = status;
-        last_keystate = keystate;
-
-        vTaskDelay(xDelay);
    }
 }
 
@@ -243,6 +212,12 @@ static void oledTask(void *pvParameters) {
     u8 incoming_btn;
     u8 incoming_dir;
 
+    // The SSD is refreshed from the TTC interrupt, only the score is written
+    if (SSD_startRefresh(&xInterruptController) != XST_SUCCESS) {
+        xil_printf("SSD refresh timer setup failed\r\n");
+    }
+    SSD_showDecimal(score);
+
     OLED_SetDrawMode(&oledDevice, 0); // draw mode == set mode
     OLED_SetCharUpdate(&oledDevice, 0); // automatic updating off
 
@@ -277,9 +252,9 @@ static void oledTask(void *pvParameters) {
             // update game logic
             int is_alive = update_game(&head, &consumable, current_direction);
             
-            // broadcast new score
+            // show new score
             if (score != previous_score) {
-                xQueueSend(xScoreQueue, &score, 0);
+                SSD_showDecimal(score);
                 previous_score = score;
             }
 
@@ -333,60 +308,6 @@ static void buttonTask(void *pvParameters) {
     }
 }
 
-// Displays points on the SSD
-static void ssdTask(void *pvParameters) {
-    (void) pvParameters;
-
-    const TickType_t xDelay = pdMS_TO_TICKS(12); // switching delay
-    const u8 left_side = 0x0;
-    const u8 right_side = 0x1; 
-
-    u8 local_score = 0;
-    u32 display_val = 0;
-
-    while(1) {
-        xQueueReceive(xScoreQueue, &local_score, 0);
-
-        // display the ones digit
-        display_val = SSD_decode(local_score % 10, right_side);
-        XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, display_val);
-        vTaskDelay(xDelay);
-
-
-        // display the tens digit
-        display_val = SSD_decode((local_score / 10) % 10, left_side);
-        XGpio_DiscreteWrite(&SSDInst, SSD_CHANNEL, display_val);
-        vTaskDelay(xDelay);
-    }
-}
-
-static u32 SSD_decode(u8 num, u8 cathode) {
-    u32 result;
-    
-    // num == the value to display
-    switch(num) { // Handles the coding of the 7-seg display
-        case 0: result = 0b00111111; break; // 0
-        case 1: result = 0b00110000; break; // 1
-        case 2: result = 0b01011011; break; // 2
-        case 3: result = 0b01111001; break; // 3
-        case 4: result = 0b01110100; break; // 4
-        case 5: result = 0b01101101; break; // 5
-        case 6: result = 0b01101111; break; // 6
-        case 7: result = 0b00111000; break; // 7
-        case 8: result = 0b01111111; break; // 8
-        case 9: result = 0b01111100; break; // 9
-        default: result = 0b00000000; break; // default case - all seven segments are OFF
-    }
-
-    // cathode handles which display is active (left or right)
-    // by setting the MSB to 1 or 0
-    if (cathode == 0) {
-        return result;
-    } else {
-        return result | 0b10000000;
-    }
-}
-
 static snake_block *start_game(void) {
     score = 0;
     snake_block *head = malloc(sizeof(snake_block));
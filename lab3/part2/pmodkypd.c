@@ -3,6 +3,9 @@
 /*************************** Function Prototypes ************************/
 
 u8 KYPD_lookupShiftPattern(u16 shift);
+u16 KYPD_scanColumnWalk(PmodKYPD *InstancePtr);
+u16 KYPD_scanShiftPattern(PmodKYPD *InstancePtr);
+void KYPD_pushEvent(PmodKYPD *InstancePtr, u32 index, u32 type, u32 now);
 
 /************************** Function Definitions ************************/
 
@@ -20,11 +23,27 @@ u8 KYPD_lookupShiftPattern(u16 shift);
 **      Initialize the PmodKYPD driver device
 */
 void KYPD_begin(PmodKYPD *InstancePtr, u32 GPIO_Address) {
+   int i;
+
    InstancePtr->GPIO_addr = GPIO_Address;
    // Set tri-state register, lower 4 pins are column outputs, upper 4 pins are
    // row inputs
-   Xil_Out32(InstancePtr->GPIO_addr + 4, 0xF0);
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_TRI_OFFSET, 0xF0);
    InstancePtr->keytable_loaded = FALSE;
+   InstancePtr->scan_mode = KYPD_SCAN_COLUMN_WALK;
+   InstancePtr->scan_cost = 0;
+   InstancePtr->last_keystate = 0;
+   InstancePtr->debounced = 0;
+   InstancePtr->unsettled = 0;
+   InstancePtr->repeat_tick = 0;
+   InstancePtr->event_head = 0;
+   InstancePtr->event_tail = 0;
+   InstancePtr->events_dropped = 0;
+   for (i = 0; i < 16; i++)
+      InstancePtr->integrator[i] = 0;
+#ifndef KYPD_NO_RTOS
+   InstancePtr->notify_task = NULL;
+#endif
 }
 
 /* -------------------------------------------------------------------- */
@@ -41,7 +60,8 @@ void KYPD_begin(PmodKYPD *InstancePtr, u32 GPIO_Address) {
 **      Set the column output pins
 */
 void KYPD_setCols(PmodKYPD *InstancePtr, u32 cols) {
-   Xil_Out32(InstancePtr->GPIO_addr, cols & 0xF);
+   InstancePtr->scan_cost++;
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_DATA_OFFSET, cols & 0xF);
 }
 
 /* -------------------------------------------------------------------- */
@@ -57,7 +77,8 @@ void KYPD_setCols(PmodKYPD *InstancePtr, u32 cols) {
 **      Read the row input pins
 */
 u32 KYPD_getRows(PmodKYPD *InstancePtr) {
-   return (Xil_In32(InstancePtr->GPIO_addr) >> 4) & 0xF;
+   InstancePtr->scan_cost++;
+   return (Xil_In32(InstancePtr->GPIO_addr + KYPD_GPIO_DATA_OFFSET) >> 4) & 0xF;
 }
 
 /* -------------------------------------------------------------------- */
@@ -71,13 +92,103 @@ u32 KYPD_getRows(PmodKYPD *InstancePtr) {
 **                Each set of four keys on a single row are grouped together.
 **
 **   Description:
-**      Capture the state of each key on the keypad
+**      Capture the state of each key on the keypad using the scan selected by
+**      KYPD_setScanMode. The number of GPIO transactions the scan took is
+**      available afterwards from KYPD_getScanCost.
+*/
+u16 KYPD_getKeyStates(PmodKYPD *InstancePtr) {
+   InstancePtr->scan_cost = 0;
+
+   if (InstancePtr->scan_mode == KYPD_SCAN_SHIFT_PATTERN)
+      return KYPD_scanShiftPattern(InstancePtr);
+   return KYPD_scanColumnWalk(InstancePtr);
+}
+
+/* -------------------------------------------------------------------- */
+/*** void KYPD_setScanMode(PmodKYPD *InstancePtr, u32 mode)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      mode:        KYPD_SCAN_COLUMN_WALK (default) or
+**                   KYPD_SCAN_SHIFT_PATTERN
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Select how KYPD_getKeyStates scans the matrix
+*/
+void KYPD_setScanMode(PmodKYPD *InstancePtr, u32 mode) {
+   InstancePtr->scan_mode = mode;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_getScanCost(PmodKYPD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**
+**   Return Value:
+**      cost: Number of GPIO register accesses made by the last
+**            KYPD_getKeyStates call (8 for the column walk, 32 for the
+**            shift pattern scan)
+**
+**   Description:
+**      Report the bus cost of the last scan
+*/
+u32 KYPD_getScanCost(PmodKYPD *InstancePtr) {
+   return InstancePtr->scan_cost;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u16 KYPD_scanColumnWalk(PmodKYPD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**
+**   Return Value:
+**      keystate: see KYPD_getKeyStates
+**
+**   Description:
+**      Drive one column low at a time and read the rows back. A low row means
+**      the key at that row/column intersection is pressed, so the keystate is
+**      built directly without any pattern decoding.
+*/
+u16 KYPD_scanColumnWalk(PmodKYPD *InstancePtr) {
+   u32 col, rows;
+   u16 keystate = 0;
+
+   for (col = 0; col < 4; col++) {
+      KYPD_setCols(InstancePtr, ~(1 << col));
+      rows = ~KYPD_getRows(InstancePtr) & 0xF;
+      // Spread the row bits out to one per nibble. Column n lands on bit
+      // (3 - n) of its row, the same layout KYPD_lookupShiftPattern returns.
+      rows = (rows & 0x1) | (rows & 0x2) << 3 | (rows & 0x4) << 6 |
+             (rows & 0x8) << 9;
+      keystate |= rows << (3 - col);
+   }
+
+   return keystate;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u16 KYPD_scanShiftPattern(PmodKYPD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**
+**   Return Value:
+**      keystate: see KYPD_getKeyStates
+**
+**   Description:
+**      Fallback scan that walks all 16 column combinations and decodes each
+**      row through KYPD_lookupShiftPattern
 **
 **   Errors:
 **      Multiple key presses may not be detected properly - it can be detected
 **      that multiple keys are pressed, but not which.
 */
-u16 KYPD_getKeyStates(PmodKYPD *InstancePtr) {
+u16 KYPD_scanShiftPattern(PmodKYPD *InstancePtr) {
    u32 rows, cols;
    u16 keystate;
    u16 shift[4] = {0, 0, 0, 0};
@@ -159,22 +270,10 @@ void KYPD_loadKeyTable(PmodKYPD *InstancePtr, u8 keytable[16]) {
 **    return the human-readable character that the pressed key represents
 */
 u32 KYPD_getKeyPressed(PmodKYPD *InstancePtr, u16 keystate, u8 *cptr) {
-   u8 i = 0;
-   u8 ci = 0;
-   u32 count = 0;
-
-   for (i = 0; i < 16; i++) {
-      // If key reading is 0 (pressed)
-      if (0x1 == (keystate & 0x1)) {
-         count++; // Count the number of pressed keys
-         ci = i;
-      }
-      // Increment through keystate bits
-      keystate >>= 1;
-   }
+   u32 count = KYPD_countKeys(keystate);
 
    if (count > 1) {
-      // Multiple keys pressed, cannot differentiate which
+      // Multiple keys pressed, use KYPD_getKeysPressed to tell them apart
       return KYPD_MULTI_KEY;
    } else if (count == 0) {
       // No key pressed
@@ -182,13 +281,134 @@ u32 KYPD_getKeyPressed(PmodKYPD *InstancePtr, u16 keystate, u8 *cptr) {
    } else {
       // One key pressed
       if (InstancePtr->keytable_loaded == TRUE)
-         *cptr = InstancePtr->keytable[ci]; // Return human-readable key label
+         *cptr = InstancePtr->keytable[KYPD_nextKey(&keystate)];
       else
-         *cptr = ci; // Return index of pressed key
+         *cptr = KYPD_nextKey(&keystate); // Return index of pressed key
       return KYPD_SINGLE_KEY;
    }
 }
 
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_getKeysPressed(PmodKYPD *InstancePtr, u16 keystate, u8 keys[16],
+**                           u32 *count)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      keystate:    Status of each key, as returned by KYPD_getKeyStates
+**      keys:        Array to return one entry per pressed key, in keystate
+**                   bit order. Entries are human-readable characters when the
+**                   keytable is loaded and key indices otherwise.
+**      count:       Address to return the number of pressed keys
+**
+**   Return Value:
+**      status:
+**         KYPD_NO_KEY when no keys are pressed.
+**         KYPD_SINGLE_KEY when only one key is pressed.
+**         KYPD_MULTI_KEY when several keys are pressed and all are real.
+**         KYPD_GHOST_KEY when the pressed keys form a rectangle on the matrix,
+**            so one of the reported keys may be a ghost.
+**
+**   Description:
+**      Decode every pressed key, so chords can be handled instead of being
+**      collapsed into KYPD_MULTI_KEY
+*/
+u32 KYPD_getKeysPressed(PmodKYPD *InstancePtr, u16 keystate, u8 keys[16],
+                        u32 *count) {
+   u16 keyset = keystate;
+   u32 n = 0;
+   u32 ci;
+
+   while (keyset != 0) {
+      ci = KYPD_nextKey(&keyset);
+      keys[n++] = (InstancePtr->keytable_loaded == TRUE)
+                     ? InstancePtr->keytable[ci]
+                     : ci;
+   }
+   *count = n;
+
+   if (n == 0)
+      return KYPD_NO_KEY;
+   else if (n == 1)
+      return KYPD_SINGLE_KEY;
+   else if (KYPD_isGhosted(keystate))
+      return KYPD_GHOST_KEY;
+   return KYPD_MULTI_KEY;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_countKeys(u16 keystate)
+**
+**   Parameters:
+**      keystate: Status of each key, as returned by KYPD_getKeyStates
+**
+**   Return Value:
+**      count: Number of pressed keys
+**
+**   Description:
+**      Population count of the keystate
+*/
+u32 KYPD_countKeys(u16 keystate) {
+   return __builtin_popcount(keystate);
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_nextKey(u16 *keyset)
+**
+**   Parameters:
+**      keyset: Set of keys to iterate, updated in place
+**
+**   Return Value:
+**      index: Bit position of the lowest pressed key in keyset
+**
+**   Description:
+**      Remove and return the lowest key of a non-empty key set. Iterate all
+**      pressed keys with: while (keyset != 0) i = KYPD_nextKey(&keyset);
+*/
+u32 KYPD_nextKey(u16 *keyset) {
+   u32 index = __builtin_ctz(*keyset);
+
+   *keyset &= *keyset - 1;
+   return index;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_isGhosted(u16 keystate)
+**
+**   Parameters:
+**      keystate: Status of each key, as returned by KYPD_getKeyStates
+**
+**   Return Value:
+**      ghosted: TRUE if the keystate may contain a ghost key
+**
+**   Description:
+**      The keypad has no diodes, so three keys on the corners of a rectangle
+**      connect the fourth corner's row and column and it reads as pressed.
+**      A ghost can only appear when two rows share two or more columns.
+*/
+u32 KYPD_isGhosted(u16 keystate) {
+   u32 r0 = keystate & 0xF;
+   u32 r1 = (keystate >> 4) & 0xF;
+   u32 r2 = (keystate >> 8) & 0xF;
+   u32 r3 = (keystate >> 12) & 0xF;
+   u32 shared;
+
+   // Columns in common for every pair of rows, x & (x - 1) is non-zero when
+   // x has more than one bit set
+   shared = r0 & r1;
+   if (shared & (shared - 1)) return TRUE;
+   shared = r0 & r2;
+   if (shared & (shared - 1)) return TRUE;
+   shared = r0 & r3;
+   if (shared & (shared - 1)) return TRUE;
+   shared = r1 & r2;
+   if (shared & (shared - 1)) return TRUE;
+   shared = r1 & r3;
+   if (shared & (shared - 1)) return TRUE;
+   shared = r2 & r3;
+   if (shared & (shared - 1)) return TRUE;
+   return FALSE;
+}
+
 /* -------------------------------------------------------------------- */
 /*** u8 KYPD_lookupShiftPattern(u16 shift)
 **
@@ -227,3 +447,342 @@ u8 KYPD_lookupShiftPattern(u16 shift) {
    default:     return 0x0;
    }
 }
+
+
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_processKeyStates(PmodKYPD *InstancePtr, u16 keystate, u32 now)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      keystate:    Raw keystate from a scan
+**      now:         Current tick count
+**
+**   Return Value:
+**      count: Number of events added to the event queue
+**
+**   Description:
+**      Feed one raw sample through the per-key integrator debounce. A key is
+**      reported pressed after KYPD_DEBOUNCE_SAMPLES consecutive samples read
+**      it down, and released after the same number read it up, so contact
+**      bounce never reaches the event queue. Keys that stay held generate
+**      KYPD_EVENT_REPEAT after KYPD_REPEAT_DELAY, then every
+**      KYPD_REPEAT_PERIOD.
+*/
+u32 KYPD_processKeyStates(PmodKYPD *InstancePtr, u16 keystate, u32 now) {
+   u32 queued = InstancePtr->event_head;
+   u16 active = (keystate ^ InstancePtr->debounced) | InstancePtr->unsettled;
+   u16 mask;
+   u32 i;
+
+   for (i = 0, mask = 1; active != 0; i++, mask <<= 1, active >>= 1) {
+      if (0x1 != (active & 0x1))
+         continue;
+
+      if (keystate & mask) {
+         if (InstancePtr->integrator[i] < KYPD_DEBOUNCE_SAMPLES)
+            InstancePtr->integrator[i]++;
+      } else if (InstancePtr->integrator[i] > 0) {
+         InstancePtr->integrator[i]--;
+      }
+
+      if (InstancePtr->integrator[i] == KYPD_DEBOUNCE_SAMPLES) {
+         InstancePtr->unsettled &= ~mask;
+         if (!(InstancePtr->debounced & mask)) {
+            InstancePtr->debounced |= mask;
+            InstancePtr->repeat_tick = now + KYPD_REPEAT_DELAY;
+            KYPD_pushEvent(InstancePtr, i, KYPD_EVENT_PRESS, now);
+         }
+      } else if (InstancePtr->integrator[i] == 0) {
+         InstancePtr->unsettled &= ~mask;
+         if (InstancePtr->debounced & mask) {
+            InstancePtr->debounced &= ~mask;
+            KYPD_pushEvent(InstancePtr, i, KYPD_EVENT_RELEASE, now);
+         }
+      } else {
+         InstancePtr->unsettled |= mask;
+      }
+   }
+
+   // Auto-repeat every key that is still held once its delay has passed
+   if (InstancePtr->debounced != 0 &&
+       (s32) (now - InstancePtr->repeat_tick) >= 0) {
+      mask = InstancePtr->debounced;
+      while (mask != 0) {
+         i = KYPD_nextKey(&mask);
+         KYPD_pushEvent(InstancePtr, i, KYPD_EVENT_REPEAT, now);
+      }
+      InstancePtr->repeat_tick = now + KYPD_REPEAT_PERIOD;
+   }
+
+   return InstancePtr->event_head - queued;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u32 KYPD_pollEvents(PmodKYPD *InstancePtr, u32 now)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      now:         Current tick count
+**
+**   Return Value:
+**      count: Number of events added to the event queue
+**
+**   Description:
+**      Scan the keypad once and debounce the result. Call this every
+**      KYPD_POLL_PERIOD, then drain the queue with KYPD_readEvent.
+*/
+u32 KYPD_pollEvents(PmodKYPD *InstancePtr, u32 now) {
+   return KYPD_processKeyStates(InstancePtr, KYPD_getKeyStates(InstancePtr),
+                                now);
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus KYPD_readEvent(PmodKYPD *InstancePtr, KYPD_Event *event)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      event:       Address to return the oldest queued event
+**
+**   Return Value:
+**      status:
+**         XST_SUCCESS when an event was returned.
+**         XST_NO_DATA when the event queue is empty.
+**
+**   Description:
+**      Pop one event from the keypad event queue without blocking
+*/
+XStatus KYPD_readEvent(PmodKYPD *InstancePtr, KYPD_Event *event) {
+   if (InstancePtr->event_tail == InstancePtr->event_head)
+      return XST_NO_DATA;
+
+   *event = InstancePtr->events[InstancePtr->event_tail &
+                                (KYPD_EVENT_QUEUE_LEN - 1)];
+   InstancePtr->event_tail++;
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** u16 KYPD_getDebouncedKeyStates(PmodKYPD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**
+**   Return Value:
+**      keystate: Debounced keystate, same layout as KYPD_getKeyStates
+**
+**   Description:
+**      Return the key states as last seen by the debounce
+*/
+u16 KYPD_getDebouncedKeyStates(PmodKYPD *InstancePtr) {
+   return InstancePtr->debounced;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void KYPD_pushEvent(PmodKYPD *InstancePtr, u32 index, u32 type, u32 now)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      index:       Bit position of the key in the keystate
+**      type:        KYPD_EVENT_PRESS, KYPD_EVENT_RELEASE or KYPD_EVENT_REPEAT
+**      now:         Current tick count
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Append an event to the queue, dropping it if the queue is full
+*/
+void KYPD_pushEvent(PmodKYPD *InstancePtr, u32 index, u32 type, u32 now) {
+   KYPD_Event *event;
+
+   if (InstancePtr->event_head - InstancePtr->event_tail >=
+       KYPD_EVENT_QUEUE_LEN) {
+      InstancePtr->events_dropped++;
+      return;
+   }
+
+   event = &InstancePtr->events[InstancePtr->event_head &
+                                (KYPD_EVENT_QUEUE_LEN - 1)];
+   event->key = (InstancePtr->keytable_loaded == TRUE)
+                   ? InstancePtr->keytable[index]
+                   : index;
+   event->index = index;
+   event->type = type;
+   event->tick = now;
+   InstancePtr->event_head++;
+}
+
+#ifndef KYPD_NO_RTOS
+/* -------------------------------------------------------------------- */
+/*** void KYPD_enableInterrupt(PmodKYPD *InstancePtr, TaskHandle_t NotifyTask)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      NotifyTask:  Task to notify with the new keystate after each scan
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Switch the keypad to interrupt-driven scanning. All columns are driven
+**      low so that pressing or releasing any key changes a row input, which
+**      raises the AXI GPIO channel 1 interrupt. The matrix is only scanned
+**      from KYPD_InterruptHandler, so an idle keypad costs no bus traffic.
+**
+**      The caller must connect KYPD_InterruptHandler to the GPIO interrupt
+**      line on the GIC (the GPIO IP needs C_INTERRUPT_PRESENT = 1). While
+**      this mode is active, use KYPD_waitKeyStates instead of calling
+**      KYPD_getKeyStates from a task.
+*/
+void KYPD_enableInterrupt(PmodKYPD *InstancePtr, TaskHandle_t NotifyTask) {
+   InstancePtr->notify_task = NotifyTask;
+   InstancePtr->last_keystate = KYPD_getKeyStates(InstancePtr);
+
+   // Park the columns low so any key pulls its row down
+   KYPD_setCols(InstancePtr, 0x0);
+
+   // Drop stale events (the status bits are toggle-on-write), then arm
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_ISR_OFFSET,
+             Xil_In32(InstancePtr->GPIO_addr + KYPD_GPIO_ISR_OFFSET));
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_IER_OFFSET, KYPD_GPIO_CH1_MASK);
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_GIER_OFFSET, KYPD_GPIO_GIE_MASK);
+}
+
+/* -------------------------------------------------------------------- */
+/*** void KYPD_disableInterrupt(PmodKYPD *InstancePtr)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Return the keypad to polled mode
+*/
+void KYPD_disableInterrupt(PmodKYPD *InstancePtr) {
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_GIER_OFFSET, 0);
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_IER_OFFSET, 0);
+   InstancePtr->notify_task = NULL;
+}
+
+/* -------------------------------------------------------------------- */
+/*** void KYPD_InterruptHandler(void *CallBackRef)
+**
+**   Parameters:
+**      CallBackRef: The PmodKYPD device passed to XScuGic_Connect
+**
+**   Return Value:
+**      none
+**
+**   Description:
+**      Row-change interrupt handler. Runs one full matrix scan, stores the
+**      result in last_keystate and hands it to the waiting task through its
+**      notification value.
+*/
+void KYPD_InterruptHandler(void *CallBackRef) {
+   PmodKYPD *InstancePtr = (PmodKYPD *) CallBackRef;
+   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+   u16 keystate;
+
+   // Mask the channel while scanning, the scan itself toggles the rows
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_IER_OFFSET, 0);
+
+   keystate = KYPD_getKeyStates(InstancePtr);
+   InstancePtr->last_keystate = keystate;
+   KYPD_setCols(InstancePtr, 0x0);
+
+   // Discard the edges generated by the scan and re-arm
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_ISR_OFFSET,
+             Xil_In32(InstancePtr->GPIO_addr + KYPD_GPIO_ISR_OFFSET));
+   Xil_Out32(InstancePtr->GPIO_addr + KYPD_GPIO_IER_OFFSET, KYPD_GPIO_CH1_MASK);
+
+   if (InstancePtr->notify_task != NULL) {
+      xTaskNotifyFromISR(InstancePtr->notify_task, keystate,
+                         eSetValueWithOverwrite, &xHigherPriorityTaskWoken);
+   }
+
+   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus KYPD_waitKeyStates(PmodKYPD *InstancePtr, TickType_t timeout,
+**                              u16 *keystate)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      timeout:     Ticks to block waiting for the keypad to change
+**      keystate:    Address to return the new keystate
+**
+**   Return Value:
+**      status:
+**         XST_SUCCESS when the keypad changed, keystate is loaded.
+**         XST_NO_DATA when the timeout expired, keystate is loaded with the
+**            last known state.
+**
+**   Description:
+**      Block the calling task (which must be the NotifyTask passed to
+**      KYPD_enableInterrupt) until the keypad interrupt delivers a scan.
+*/
+XStatus KYPD_waitKeyStates(PmodKYPD *InstancePtr, TickType_t timeout,
+                           u16 *keystate) {
+   uint32_t value;
+
+   if (xTaskNotifyWait(0, 0xFFFFFFFF, &value, timeout) != pdTRUE) {
+      *keystate = InstancePtr->last_keystate;
+      return XST_NO_DATA;
+   }
+
+   *keystate = (u16) value;
+   return XST_SUCCESS;
+}
+
+/* -------------------------------------------------------------------- */
+/*** XStatus KYPD_waitEvent(PmodKYPD *InstancePtr, KYPD_Event *event,
+**                          TickType_t timeout)
+**
+**   Parameters:
+**      InstancePtr: A PmodKYPD device to use
+**      event:       Address to return the next keypad event
+**      timeout:     Ticks to block, portMAX_DELAY to wait forever
+**
+**   Return Value:
+**      status:
+**         XST_SUCCESS when an event was returned.
+**         XST_NO_DATA when the timeout expired first.
+**
+**   Description:
+**      Block the calling task until a debounced press, release or repeat
+**      event is available. In polled mode the keypad is sampled every
+**      KYPD_POLL_PERIOD. In interrupt mode the task sleeps on the keypad
+**      interrupt while all keys are up and settled, and only samples at
+**      KYPD_POLL_PERIOD while a key is bouncing or held.
+*/
+XStatus KYPD_waitEvent(PmodKYPD *InstancePtr, KYPD_Event *event,
+                       TickType_t timeout) {
+   TickType_t start = xTaskGetTickCount();
+   TickType_t elapsed, wait;
+   u16 keystate;
+
+   while (KYPD_readEvent(InstancePtr, event) != XST_SUCCESS) {
+      elapsed = xTaskGetTickCount() - start;
+      if (timeout != portMAX_DELAY && elapsed >= timeout)
+         return XST_NO_DATA;
+
+      if (InstancePtr->notify_task != NULL) {
+         wait = KYPD_POLL_PERIOD;
+         if (InstancePtr->debounced == 0 && InstancePtr->unsettled == 0)
+            wait = (timeout == portMAX_DELAY) ? portMAX_DELAY
+                                              : timeout - elapsed;
+         KYPD_waitKeyStates(InstancePtr, wait, &keystate);
+      } else {
+         vTaskDelay(KYPD_POLL_PERIOD);
+         keystate = KYPD_getKeyStates(InstancePtr);
+      }
+
+      KYPD_processKeyStates(InstancePtr, keystate, xTaskGetTickCount());
+   }
+
+   return XST_SUCCESS;
+}
+#endif
@@ -0,0 +1,201 @@
+/*
+ * ssd_driver.c
+ *
+ * Timer-driven seven-segment display multiplexing. Each TTC interval
+ * interrupt writes the next framebuffer entry to the SSD GPIO, so the refresh
+ * rate does not depend on task scheduling.
+ */
+
+#include "ssd_driver.h"
+#include "xttcps.h"
+
+// -------------------------------------------------
+// Driver state
+// -------------------------------------------------
+static XTtcPs SSDTimer;
+static u32 ssdBaseAddress;
+
+// Framebuffer, one GPIO word per digit with the cathode bit already applied
+static volatile u8 framebuffer[SSD_NUM_DIGITS];
+static u32 currentDigit;
+
+// -------------------------------------------------
+// Glyphs
+// -------------------------------------------------
+// Segments in the usual a-g order, so the Pmod wiring is only in the
+// SSD_SEG_* defines
+#define SSD_GLYPH(a, b, c, d, e, f, g)                                         \
+    (((a) ? SSD_SEG_A : 0) | ((b) ? SSD_SEG_B : 0) | ((c) ? SSD_SEG_C : 0) |   \
+     ((d) ? SSD_SEG_D : 0) | ((e) ? SSD_SEG_E : 0) | ((f) ? SSD_SEG_F : 0) |   \
+     ((g) ? SSD_SEG_G : 0))
+
+const u8 SSD_glyphs[128] = {
+    //              a  b  c  d  e  f  g
+    ['0'] = SSD_GLYPH(1, 1, 1, 1, 1, 1, 0),
+    ['1'] = SSD_GLYPH(0, 1, 1, 0, 0, 0, 0),
+    ['2'] = SSD_GLYPH(1, 1, 0, 1, 1, 0, 1),
+    ['3'] = SSD_GLYPH(1, 1, 1, 1, 0, 0, 1),
+    ['4'] = SSD_GLYPH(0, 1, 1, 0, 0, 1, 1),
+    ['5'] = SSD_GLYPH(1, 0, 1, 1, 0, 1, 1),
+    ['6'] = SSD_GLYPH(1, 0, 1, 1, 1, 1, 1),
+    ['7'] = SSD_GLYPH(1, 1, 1, 0, 0, 0, 0),
+    ['8'] = SSD_GLYPH(1, 1, 1, 1, 1, 1, 1),
+    ['9'] = SSD_GLYPH(1, 1, 1, 0, 0, 1, 1),
+
+    // Letters that have no distinct upper case glyph share one pattern
+    ['A'] = SSD_GLYPH(1, 1, 1, 0, 1, 1, 1),
+    ['a'] = SSD_GLYPH(1, 1, 1, 0, 1, 1, 1),
+    ['B'] = SSD_GLYPH(0, 0, 1, 1, 1, 1, 1), // shown as b
+    ['b'] = SSD_GLYPH(0, 0, 1, 1, 1, 1, 1),
+    ['C'] = SSD_GLYPH(1, 0, 0, 1, 1, 1, 0),
+    ['c'] = SSD_GLYPH(0, 0, 0, 1, 1, 0, 1),
+    ['D'] = SSD_GLYPH(0, 1, 1, 1, 1, 0, 1), // shown as d
+    ['d'] = SSD_GLYPH(0, 1, 1, 1, 1, 0, 1),
+    ['E'] = SSD_GLYPH(1, 0, 0, 1, 1, 1, 1),
+    ['e'] = SSD_GLYPH(1, 0, 0, 1, 1, 1, 1),
+    ['F'] = SSD_GLYPH(1, 0, 0, 0, 1, 1, 1),
+    ['f'] = SSD_GLYPH(1, 0, 0, 0, 1, 1, 1),
+    ['G'] = SSD_GLYPH(1, 0, 1, 1, 1, 1, 0),
+    ['g'] = SSD_GLYPH(1, 0, 1, 1, 1, 1, 0),
+    ['H'] = SSD_GLYPH(0, 1, 1, 0, 1, 1, 1),
+    ['h'] = SSD_GLYPH(0, 0, 1, 0, 1, 1, 1),
+    ['I'] = SSD_GLYPH(0, 0, 0, 0, 1, 1, 0), // left side, unlike 1
+    ['i'] = SSD_GLYPH(0, 0, 0, 0, 1, 1, 0),
+    ['J'] = SSD_GLYPH(0, 1, 1, 1, 1, 0, 0),
+    ['j'] = SSD_GLYPH(0, 1, 1, 1, 1, 0, 0),
+    ['L'] = SSD_GLYPH(0, 0, 0, 1, 1, 1, 0),
+    ['l'] = SSD_GLYPH(0, 0, 0, 1, 1, 1, 0),
+    ['N'] = SSD_GLYPH(0, 0, 1, 0, 1, 0, 1), // shown as n
+    ['n'] = SSD_GLYPH(0, 0, 1, 0, 1, 0, 1),
+    ['O'] = SSD_GLYPH(1, 1, 1, 1, 1, 1, 0),
+    ['o'] = SSD_GLYPH(0, 0, 1, 1, 1, 0, 1),
+    ['P'] = SSD_GLYPH(1, 1, 0, 0, 1, 1, 1),
+    ['p'] = SSD_GLYPH(1, 1, 0, 0, 1, 1, 1),
+    ['Q'] = SSD_GLYPH(1, 1, 1, 0, 0, 1, 1), // shown as q
+    ['q'] = SSD_GLYPH(1, 1, 1, 0, 0, 1, 1),
+    ['R'] = SSD_GLYPH(0, 0, 0, 0, 1, 0, 1), // shown as r
+    ['r'] = SSD_GLYPH(0, 0, 0, 0, 1, 0, 1),
+    ['S'] = SSD_GLYPH(1, 0, 1, 1, 0, 1, 1),
+    ['s'] = SSD_GLYPH(1, 0, 1, 1, 0, 1, 1),
+    ['T'] = SSD_GLYPH(0, 0, 0, 1, 1, 1, 1), // shown as t
+    ['t'] = SSD_GLYPH(0, 0, 0, 1, 1, 1, 1),
+    ['U'] = SSD_GLYPH(0, 1, 1, 1, 1, 1, 0),
+    ['u'] = SSD_GLYPH(0, 0, 1, 1, 1, 0, 0),
+    ['Y'] = SSD_GLYPH(0, 1, 1, 1, 0, 1, 1), // shown as y
+    ['y'] = SSD_GLYPH(0, 1, 1, 1, 0, 1, 1),
+
+    ['-'] = SSD_GLYPH(0, 0, 0, 0, 0, 0, 1),
+    ['_'] = SSD_GLYPH(0, 0, 0, 1, 0, 0, 0),
+    ['='] = SSD_GLYPH(0, 0, 0, 1, 0, 0, 1),
+};
+
+static const u8 hexChars[16] = "0123456789ABCDEF";
+
+// -------------------------------------------------
+// Interrupt Handler
+// -------------------------------------------------
+void SSD_interruptHandler(void *CallBackRef) {
+    XTtcPs *TimerPtr = (XTtcPs *)CallBackRef;
+
+    XTtcPs_ClearInterruptStatus(TimerPtr, XTtcPs_GetInterruptStatus(TimerPtr));
+
+    currentDigit ^= 1;
+    Xil_Out32(ssdBaseAddress + SSD_GPIO_DATA_OFFSET, framebuffer[currentDigit]);
+}
+
+// -------------------------------------------------
+// Framebuffer
+// -------------------------------------------------
+void SSD_setDigit(u32 digit, u8 segments) {
+    segments &= SSD_SEGMENT_MASK;
+    if (digit == SSD_DIGIT_RIGHT) segments |= SSD_CATHODE_MASK;
+    framebuffer[digit & 0x1] = segments;
+}
+
+void SSD_setDigits(u8 left, u8 right) {
+    SSD_setDigit(SSD_DIGIT_LEFT, left);
+    SSD_setDigit(SSD_DIGIT_RIGHT, right);
+}
+
+void SSD_clear(void) { SSD_setDigits(0, 0); }
+
+u8 SSD_encode(u8 c) { return (c < 128) ? SSD_glyphs[c] : 0; }
+
+void SSD_showChars(u8 left, u8 right) {
+    SSD_setDigits(SSD_encode(left), SSD_encode(right));
+}
+
+// Two decimal digits, values above 99 show their last two digits
+void SSD_showDecimal(u32 value) {
+    u32 tens;
+
+    if (value > 99) value %= 100;
+
+    // value / 10 for 0-99 as a multiply and shift, 205 / 2048 ~= 1 / 10
+    tens = (value * 205) >> 11;
+    SSD_setDigits(SSD_glyphs[hexChars[tens]],
+                  SSD_glyphs[hexChars[value - tens * 10]]);
+}
+
+void SSD_showHex(u8 value) {
+    SSD_setDigits(SSD_glyphs[hexChars[value >> 4]],
+                  SSD_glyphs[hexChars[value & 0xF]]);
+}
+
+// -------------------------------------------------
+// Initialization
+// -------------------------------------------------
+void SSD_begin(u32 GpioBaseAddress) {
+    ssdBaseAddress = GpioBaseAddress;
+    currentDigit = SSD_DIGIT_LEFT;
+    SSD_clear();
+
+    // All pins are outputs
+    Xil_Out32(ssdBaseAddress + SSD_GPIO_TRI_OFFSET, 0x0);
+    Xil_Out32(ssdBaseAddress + SSD_GPIO_DATA_OFFSET, framebuffer[currentDigit]);
+}
+
+// The GIC must already be initialized, so call this from a task once the
+// scheduler is running (FreeRTOS sets up xInterruptController for its tick).
+int SSD_startRefresh(XScuGic *IntcInstancePtr) {
+    XTtcPs_Config *TimerConfig;
+    XInterval interval;
+    u8 prescaler;
+    int Status;
+
+    TimerConfig = XTtcPs_LookupConfig(SSD_TIMER_BASEADDR);
+    if (NULL == TimerConfig) return XST_FAILURE;
+
+    Status = XTtcPs_CfgInitialize(&SSDTimer, TimerConfig,
+                                  TimerConfig->BaseAddress);
+    if (Status == XST_DEVICE_IS_STARTED) {
+        XTtcPs_Stop(&SSDTimer);
+        Status = XTtcPs_CfgInitialize(&SSDTimer, TimerConfig,
+                                      TimerConfig->BaseAddress);
+    }
+    if (Status != XST_SUCCESS) return XST_FAILURE;
+
+    XTtcPs_SetOptions(&SSDTimer, XTTCPS_OPTION_INTERVAL_MODE |
+                                     XTTCPS_OPTION_WAVE_DISABLE);
+    XTtcPs_CalcIntervalFromFreq(&SSDTimer, SSD_REFRESH_HZ, &interval,
+                                &prescaler);
+    if (prescaler == 0xFF) return XST_FAILURE; // No interval fits the rate
+    XTtcPs_SetInterval(&SSDTimer, interval);
+    XTtcPs_SetPrescaler(&SSDTimer, prescaler);
+
+    Status = XScuGic_Connect(IntcInstancePtr, SSD_TIMER_IRQ_ID,
+                             (Xil_ExceptionHandler)SSD_interruptHandler,
+                             (void *)&SSDTimer);
+    if (Status != XST_SUCCESS) return XST_FAILURE;
+
+    XScuGic_Enable(IntcInstancePtr, SSD_TIMER_IRQ_ID);
+    XTtcPs_EnableInterrupts(&SSDTimer, XTTCPS_IXR_INTERVAL_MASK);
+    XTtcPs_Start(&SSDTimer);
+
+    return XST_SUCCESS;
+}
+
+void SSD_stopRefresh(void) {
+    XTtcPs_Stop(&SSDTimer);
+    XTtcPs_DisableInterrupts(&SSDTimer, XTTCPS_IXR_INTERVAL_MASK);
+}
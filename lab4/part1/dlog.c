@@ -0,0 +1,269 @@
+/*
+ * dlog.c
+ *
+ * The ring is multi-producer, single-consumer. A writer claims a slot by
+ * moving dlogHead forward with a compare-and-swap, fills it, then publishes
+ * it by storing the slot's sequence number with release ordering. The drain
+ * task only takes a slot once its sequence number matches, so a writer that
+ * is preempted (or interrupted by another writer) between the two steps just
+ * holds the drain back until it finishes. Nothing here blocks or masks
+ * interrupts, so DLOG() is safe from handlers.
+ *
+ * When the ring is full the record is counted in dlogDropped and discarded,
+ * the drain task reports the count once it catches up.
+ */
+
+#include "dlog.h"
+#include "xstatus.h"
+#include "xtime_l.h"
+
+#ifndef DLOG_NO_RTOS
+#include "task.h"
+#endif
+
+// -------------------------------------------------
+// Global variables
+// -------------------------------------------------
+
+// Not static so a debugger can dump it for bench/dlog_decode.c
+DlogRecord DLOG_ring[DLOG_RING_LEN];
+
+static u32 dlogHead;    // Next position to claim, moved by the writers
+static u32 dlogTail;    // Next position to drain, moved by the drain task
+static u32 dlogDropped; // Records lost to a full ring
+
+#define DLOG_FORMAT(id, fmt) fmt,
+static const char *const dlogFormats[DLOG_FORMAT_COUNT] = {
+    "dlog: %u records dropped\r\n", DLOG_FORMATS(DLOG_FORMAT)};
+#undef DLOG_FORMAT
+
+// -------------------------------------------------
+// Ring
+// -------------------------------------------------
+void DLOG_write(u16 id, const u32 *args, u32 argc) {
+    DlogRecord *rec;
+    XTime now;
+    u32 pos, i;
+
+    pos = __atomic_load_n(&dlogHead, __ATOMIC_RELAXED);
+    do {
+        if (pos - __atomic_load_n(&dlogTail, __ATOMIC_ACQUIRE) >=
+            DLOG_RING_LEN) {
+            __atomic_fetch_add(&dlogDropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&dlogHead, &pos, pos + 1, 1,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    XTime_GetTime(&now);
+
+    rec            = &DLOG_ring[pos & (DLOG_RING_LEN - 1U)];
+    rec->timestamp = (u32)now;
+    rec->id        = id;
+    rec->argc      = (u8)argc;
+    rec->magic     = DLOG_MAGIC;
+    for (i = 0; i < argc; i++) {
+        rec->args[i] = args[i];
+    }
+
+    __atomic_store_n(&rec->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+// Single consumer. Returns 1 and copies the oldest record out if it has been
+// published, 0 otherwise.
+int DLOG_read(DlogRecord *rec) {
+    const DlogRecord *slot;
+    u32 pos;
+
+    pos  = __atomic_load_n(&dlogTail, __ATOMIC_RELAXED);
+    slot = &DLOG_ring[pos & (DLOG_RING_LEN - 1U)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) return 0;
+
+    *rec = *slot;
+
+    // Hands the slot back to the writers
+    __atomic_store_n(&dlogTail, pos + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+u32 DLOG_dropped(void) {
+    return __atomic_load_n(&dlogDropped, __ATOMIC_RELAXED);
+}
+
+// -------------------------------------------------
+// Formatting
+// -------------------------------------------------
+
+// Appends one character, keeping room for the terminator
+static void putChar(char *buf, size_t size, size_t *len, char c) {
+    if (*len + 1 < size) buf[(*len)++] = c;
+}
+
+static void putNumber(char *buf, size_t size, size_t *len, u32 value,
+                      u32 base, const char *digits, int negative, int width,
+                      char pad) {
+    char tmp[10];
+    int count = 0;
+
+    do {
+        tmp[count++] = digits[value % base];
+        value /= base;
+    } while (value != 0);
+
+    width -= count + negative;
+    if (negative && pad == '0') putChar(buf, size, len, '-');
+    while (width-- > 0) {
+        putChar(buf, size, len, pad);
+    }
+    if (negative && pad != '0') putChar(buf, size, len, '-');
+    while (count > 0) {
+        putChar(buf, size, len, tmp[--count]);
+    }
+}
+
+// Expands a record into buf, always terminated. Returns the length. Shared
+// by the drain task and the host decoder so both print the same text.
+int DLOG_format(char *buf, size_t size, const DlogRecord *rec) {
+    static const char lower[] = "0123456789abcdef";
+    static const char upper[] = "0123456789ABCDEF";
+    const char *fmt;
+    size_t len = 0;
+    u32 argi   = 0;
+    u32 arg    = 0;
+    s32 tenths;
+    int width;
+    char pad;
+
+    if (size == 0) return 0;
+
+    if (rec->id >= DLOG_FORMAT_COUNT) {
+        fmt = "dlog: bad format %u\r\n";
+        arg = rec->id;
+    } else {
+        fmt = dlogFormats[rec->id];
+    }
+
+    for (; *fmt != '\0'; fmt++) {
+        if (*fmt != '%') {
+            putChar(buf, size, &len, *fmt);
+            continue;
+        }
+
+        fmt++;
+        pad = ' ';
+        if (*fmt == '0') {
+            pad = '0';
+            fmt++;
+        }
+        for (width = 0; *fmt >= '0' && *fmt <= '9'; fmt++) {
+            width = width * 10 + (*fmt - '0');
+        }
+
+        if (*fmt == '%') {
+            putChar(buf, size, &len, '%');
+            continue;
+        }
+        if (*fmt == '\0') break;
+
+        if (rec->id >= DLOG_FORMAT_COUNT) {
+            // arg already holds the bad ID
+        } else if (argi < rec->argc && argi < DLOG_MAX_ARGS) {
+            arg = rec->args[argi++];
+        } else {
+            putChar(buf, size, &len, '?');
+            continue;
+        }
+
+        switch (*fmt) {
+        case 'd':
+        case 'i':
+            putNumber(buf, size, &len,
+                      ((s32)arg < 0) ? 0U - arg : arg, 10, lower,
+                      (s32)arg < 0, width, pad);
+            break;
+        case 'u':
+            putNumber(buf, size, &len, arg, 10, lower, 0, width, pad);
+            break;
+        case 'x':
+            putNumber(buf, size, &len, arg, 16, lower, 0, width, pad);
+            break;
+        case 'X':
+            putNumber(buf, size, &len, arg, 16, upper, 0, width, pad);
+            break;
+        case 'c': putChar(buf, size, &len, (char)arg); break;
+        case 'D':
+            tenths = (s32)arg;
+            arg    = (tenths < 0) ? 0U - (u32)tenths : (u32)tenths;
+            putNumber(buf, size, &len, arg / 10, 10, lower, tenths < 0,
+                      (width > 2) ? width - 2 : 0, pad);
+            putChar(buf, size, &len, '.');
+            putChar(buf, size, &len, lower[arg % 10]);
+            break;
+        default: putChar(buf, size, &len, '?'); break;
+        }
+    }
+
+    buf[len] = '\0';
+    return (int)len;
+}
+
+#ifndef DLOG_NO_RTOS
+// -------------------------------------------------
+// Drain task
+// -------------------------------------------------
+static DlogSink dlogSink;
+
+static void sendRecord(const DlogRecord *rec) {
+#if DLOG_BINARY
+    dlogSink((const char *)rec, sizeof(*rec));
+#else
+    char line[DLOG_LINE_LEN];
+    int len;
+
+    len = DLOG_format(line, sizeof(line), rec);
+    dlogSink(line, (size_t)len);
+#endif
+}
+
+static void DLOG_task(void *pvParameters) {
+    DlogRecord rec;
+    XTime now;
+    u32 reported = 0;
+    u32 dropped;
+
+    (void)pvParameters;
+
+    for (;;) {
+        while (DLOG_read(&rec)) {
+            sendRecord(&rec);
+        }
+
+        dropped = DLOG_dropped();
+        if (dropped != reported) {
+            XTime_GetTime(&now);
+            rec.seq       = 0; // Not from the ring
+            rec.timestamp = (u32)now;
+            rec.id        = DLOG_DROPPED;
+            rec.argc      = 1;
+            rec.magic     = DLOG_MAGIC;
+            rec.args[0]   = dropped - reported;
+            sendRecord(&rec);
+            reported = dropped;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_PERIOD));
+    }
+}
+
+// Records written before this are kept and come out first
+int DLOG_start(DlogSink sink, UBaseType_t priority) {
+    dlogSink = sink;
+
+    if (xTaskCreate(DLOG_task, "dlog", configMINIMAL_STACK_SIZE * 2, NULL,
+                    priority, NULL) != pdPASS) {
+        return XST_FAILURE;
+    }
+
+    return XST_SUCCESS;
+}
+#endif
@@ -0,0 +1,85 @@
+/*
+ * dlog_formats.h
+ *
+ * Messages logged through DLOG() in this lab. Append new entries at the end,
+ * the position is the ID stored in each record, so reordering breaks the
+ * decoding of older dumps.
+ *
+ * Motor speeds and rates are floats, they are logged with DLOG_TENTHS() and
+ * printed with %D, which keeps the one decimal the old printf("%0.1f") gave
+ * without pulling newlib's float formatting into the build.
+ */
+
+#ifndef DLOG_FORMATS_H_
+#define DLOG_FORMATS_H_
+
+#define DLOG_FORMATS(X)                                                       \
+    X(LOG_POSITION, "Current position of the motor = %d steps\n")             \
+    X(LOG_POSITION_PROMPT, "Press <ENTER> to keep this value, or type a new " \
+                           "starting position and then <ENTER>\n")            \
+    X(LOG_SPEED, "Current maximum speed of the motor = %D steps/sec\n")       \
+    X(LOG_SPEED_PROMPT, "Press <ENTER> to keep this value, or type a new "    \
+                        "maximum speed number and then <ENTER>\n")            \
+    X(LOG_ACCEL,                                                              \
+      "Current maximum acceleration of the motor = %D steps/sec/sec\n")       \
+    X(LOG_ACCEL_PROMPT, "Press <ENTER> to keep this value, or type a new "    \
+                        "maximum acceleration and then <ENTER>\n")            \
+    X(LOG_DECEL,                                                              \
+      "Current maximum deceleration of the motor = %D steps/sec/sec\n")       \
+    X(LOG_DECEL_PROMPT, "Press <ENTER> to keep this value, or type a new "    \
+                        "maximum deceleration and then <ENTER>\n")            \
+    X(LOG_DESTINATION, "Destination position of the motor = %d steps\n")      \
+    X(LOG_DESTINATION_PROMPT, "Press <ENTER> to keep this value, or type a "  \
+                              "new destination position and then <ENTER>\n")  \
+    X(LOG_DWELL,                                                              \
+      "Current dwell time of the motor between movements = %i ms\n")          \
+    X(LOG_DWELL_PROMPT, "Press <ENTER> to keep this value, or type a new "    \
+                        "dwell time and then <ENTER>\n")                      \
+    X(LOG_SLOTS, "Position slots available: %i\n")                            \
+    X(LOG_SLOTS_PROMPT, "Press <ENTER> to stop entering more positions, or "  \
+                        "enter a new position and then <ENTER>\n")            \
+    X(LOG_INVALID_INPUT, "There was an invalid input from user except the "   \
+                         "valid inputs between 0-9\n"                         \
+                         "Please input the value of this parameter again!\n") \
+    X(LOG_KEEP_POSITION, "User chooses to keep the default value of current " \
+                         "position = %d steps\n\n")                           \
+    X(LOG_NEW_POSITION,                                                       \
+      "User entered the new current position = %d steps\n\n")                 \
+    X(LOG_KEEP_SPEED, "User chooses to keep the default value of rotational " \
+                      "speed = %D steps/sec\n\n")                             \
+    X(LOG_NEW_SPEED,                                                          \
+      "User entered the new rotational speed = %D steps/sec\n\n")             \
+    X(LOG_KEEP_ACCEL, "User chooses to keep the default value of rotational " \
+                      "acceleration = %D steps/sec/sec\n\n")                  \
+    X(LOG_NEW_ACCEL, "User entered the new rotational acceleration = %D "     \
+                     "steps/sec/sec\n\n")                                     \
+    X(LOG_KEEP_DECEL, "User chooses to keep the default value of rotational " \
+                      "deceleration = %D steps/sec/sec\n\n")                  \
+    X(LOG_NEW_DECEL, "User entered the new rotational deceleration = %D "     \
+                     "steps/sec/sec\n\n")                                     \
+    X(LOG_KEEP_DESTINATION, "User chooses to keep the default value of "      \
+                            "destination position = %d\n\n")                  \
+    X(LOG_NEW_DESTINATION,                                                    \
+      "User entered the new destination position = %d steps\n\n")             \
+    X(LOG_KEEP_DWELL,                                                         \
+      "User chooses to keep the default value of dwell time = %d\n")          \
+    X(LOG_NEW_DWELL, "User entered new dwell time = %d ms\n")                 \
+    X(LOG_PAIR, "*** Pair: %d\t, <destination, delay> = <%d, %d>\n\n")        \
+    X(LOG_MENU_STOP,                                                          \
+      "User chooses to stop inputting sequences, or sequence full.\n\n")      \
+    X(LOG_MENU_HEADER, "\n****************************** MENU "               \
+                       "******************************\n")                    \
+    X(LOG_MENU_OPTIONS,                                                       \
+      "1. Press m<ENTER> to change the motor parameters again.\n"             \
+      "2. Press g<ENTER> to start the movement of the motor.\n")              \
+    X(LOG_MOTOR_START, "\nStarting the Motor Rotation...\n")                  \
+    X(LOG_MOTOR_DONE, "\n\nCurrent position of the motor = %d steps\n")       \
+    X(LOG_MENU_UART_OPTIONS,                                                  \
+      "3. Press b<ENTER> to step the baud rate up to 921600, then back to "   \
+      "115200.\n"                                                             \
+      "4. Press e<ENTER> to show the UART error counts.\n")                   \
+    X(LOG_UART_ERRORS,                                                        \
+      "UART errors: overrun %u, framing %u, parity %u\n")                     \
+    X(LOG_BAUD_FAILED, "Could not set %u baud\n")
+
+#endif /* DLOG_FORMATS_H_ */
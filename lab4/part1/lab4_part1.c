@@ -32,9 +32,12 @@
  *
  */
 
+#include "dlog.h"
+#include "semphr.h"
 #include "sleep.h"
 #include "xil_cache.h"
 #include "stepper.h"
+#include "uart_config.h"
 #include "xuartps.h" 		//UART definitions header file
 #include "xgpio.h"			//GPIO functions definitions
 #include "xparameters.h"	//DEVICE ID, UART BASEADDRESS, GPIO BASE ADDRESS definitions
@@ -54,10 +57,17 @@ static void _Task_Emerg_Stop( void *pvParameters );
 static TaskHandle_t xEmergStopTask;
 
 int Initialize_UART();
+static void Log_Sink(const char *buf, size_t len);
+int Set_UART_Baud(u32 baud);
+const UartErrorCounts *Poll_UART_Errors();
+static void Report_UART_Errors(int force);
 
 /************************* Queue Function definitions *************************/
 static QueueHandle_t xQueue_FIFO1 = NULL;	//queue between task1 and task2
 
+//Held by Log_Sink for a whole message and around a baud change, so a message never goes out at two rates
+static SemaphoreHandle_t UART_Tx_Mutex = NULL;
+
 /************************* Global Variables ***********************************/
 
 //GPIO Button Instance and DEVICE ID
@@ -99,6 +109,11 @@ int positionSequence[SEQUENCE_LENGTH][2] = {{NO_OF_STEPS_PER_REVOLUTION_FULL_DRI
 int sequenceIndex = 0; // the number of position-delay sequences
 int loop_count = 1; // the number of times to repeat the position-delay sequence
 
+// b<ENTER> in the menu steps through these, the terminal has to follow
+static const u32 UART_Baud_Rates[] = {115200, 230400, 460800, UART_MAX_BAUD};
+static int UART_Baud_Index = 0;
+static u32 UART_Errors_Seen = 0; // sum of the error counts last reported
+
 //----------------------------------------------------
 // MAIN FUNCTION
 //----------------------------------------------------
@@ -153,6 +168,12 @@ int main (void)
 
 	xil_printf("\nStepper motor Initialization Complete! Operational parameters can be changed below:\n\n");
 
+	UART_Tx_Mutex = xSemaphoreCreateMutex();
+	configASSERT(UART_Tx_Mutex);
+
+	// Task messages are queued as binary records and printed by the log task at the idle priority
+	DLOG_start(Log_Sink, tskIDLE_PRIORITY);
+
 	xTaskCreate( _Task_Uart,
 				( const char * ) "Uart Task",
 				configMINIMAL_STACK_SIZE*10,
@@ -196,32 +217,32 @@ static void _Task_Uart( void *pvParameters ){
 		// print the message that corresponds to the parameter we want to get. This the menu that gets printed initially!
 		if(message_flag == 0){
 			if(parameters_flag == 0){
-				xil_printf("Current position of the motor = %d steps\n", motor_parameters.currentposition_in_steps);
-				xil_printf("Press <ENTER> to keep this value, or type a new starting position and then <ENTER>\n");
+				DLOG(LOG_POSITION, motor_parameters.currentposition_in_steps);
+				DLOG(LOG_POSITION_PROMPT);
 			}
 			else if(parameters_flag == 1){
-				printf("Current maximum speed of the motor = %0.1f steps/sec\n", motor_parameters.rotational_speed);
-				xil_printf("Press <ENTER> to keep this value, or type a new maximum speed number and then <ENTER>\n");
+				DLOG(LOG_SPEED, DLOG_TENTHS(motor_parameters.rotational_speed));
+				DLOG(LOG_SPEED_PROMPT);
 			}
 			else if(parameters_flag == 2){
-				printf("Current maximum acceleration of the motor = %0.1f steps/sec/sec\n", motor_parameters.rotational_acceleration);
-				xil_printf("Press <ENTER> to keep this value, or type a new maximum acceleration and then <ENTER>\n");
+				DLOG(LOG_ACCEL, DLOG_TENTHS(motor_parameters.rotational_acceleration));
+				DLOG(LOG_ACCEL_PROMPT);
 			}
 			else if(parameters_flag == 3){
-				printf("Current maximum deceleration of the motor = %0.1f steps/sec/sec\n", motor_parameters.rotational_deceleration);
-				xil_printf("Press <ENTER> to keep this value, or type a new maximum deceleration and then <ENTER>\n");
+				DLOG(LOG_DECEL, DLOG_TENTHS(motor_parameters.rotational_deceleration));
+				DLOG(LOG_DECEL_PROMPT);
 			}
 			else if(parameters_flag == 4){
-				xil_printf("Destination position of the motor = %d steps\n", positionSequence[sequenceIndex][0]);
-				xil_printf("Press <ENTER> to keep this value, or type a new destination position and then <ENTER>\n");
+				DLOG(LOG_DESTINATION, positionSequence[sequenceIndex][0]);
+				DLOG(LOG_DESTINATION_PROMPT);
 			}
 			else if(parameters_flag == 5){
-				xil_printf("Current dwell time of the motor between movements = %i ms\n", positionSequence[sequenceIndex][1]);
-				xil_printf("Press <ENTER> to keep this value, or type a new dwell time and then <ENTER>\n");
+				DLOG(LOG_DWELL, positionSequence[sequenceIndex][1]);
+				DLOG(LOG_DWELL_PROMPT);
 			}
 			else if(parameters_flag == 6){
-				xil_printf("Position slots available: %i\n", SEQUENCE_LENGTH - sequenceIndex);
-				xil_printf("Press <ENTER> to stop entering more positions, or enter a new position and then <ENTER>\n");
+				DLOG(LOG_SLOTS, SEQUENCE_LENGTH - sequenceIndex);
+				DLOG(LOG_SLOTS_PROMPT);
 			}
 		}
 
@@ -242,6 +263,11 @@ static void _Task_Uart( void *pvParameters ){
 					break;
 				}
 			}
+			// let the log task print the prompt while the user types
+			else{
+				Report_UART_Errors(0);
+				vTaskDelay(1);
+			}
 		}
 
 		// if only enter was pressed, keep the default parameter value
@@ -285,8 +311,7 @@ static void _Task_Uart( void *pvParameters ){
 		// notify the user on invalid data entry
 		if(invalid_input_flag == 1){
 			message_flag = 1;
-			xil_printf("There was an invalid input from user except the valid inputs between 0-9\n");
-			xil_printf("Please input the value of this parameter again!\n");
+			DLOG(LOG_INVALID_INPUT);
 		}
 		// if we are still getting motor parameters from the user
 		else if(parameters_flag <= 6){
@@ -294,64 +319,64 @@ static void _Task_Uart( void *pvParameters ){
 			// update the value with the one given by the user, or keep it as the default
 			if(parameters_flag == 0){
 				if(keep_default_value_flag == 1){
-					xil_printf("User chooses to keep the default value of current position = %d steps\n\n",motor_parameters.currentposition_in_steps);
+					DLOG(LOG_KEEP_POSITION, motor_parameters.currentposition_in_steps);
 				}
 				else{
 					motor_parameters.currentposition_in_steps = atoi(str_value_motor_value);
-					xil_printf("User entered the new current position = %d steps\n\n",motor_parameters.currentposition_in_steps);
+					DLOG(LOG_NEW_POSITION, motor_parameters.currentposition_in_steps);
 				}
 			}
 			// update the value with the one given by the user, or keep it as the default
 			else if(parameters_flag == 1){
 				if(keep_default_value_flag == 1){
-					printf("User chooses to keep the default value of rotational speed = %0.1f steps/sec\n\n",motor_parameters.rotational_speed);
+					DLOG(LOG_KEEP_SPEED, DLOG_TENTHS(motor_parameters.rotational_speed));
 				}
 				else{
 					motor_parameters.rotational_speed = atoi(str_value_motor_value);
-					printf("User entered the new rotational speed = %0.1f steps/sec\n\n",motor_parameters.rotational_speed);
+					DLOG(LOG_NEW_SPEED, DLOG_TENTHS(motor_parameters.rotational_speed));
 				}
 			}
 			// update the value with the one given by the user, or keep it as the default
 			else if(parameters_flag == 2){
 				if(keep_default_value_flag == 1){
-					printf("User chooses to keep the default value of rotational acceleration = %0.1f steps/sec/sec\n\n",motor_parameters.rotational_acceleration);
+					DLOG(LOG_KEEP_ACCEL, DLOG_TENTHS(motor_parameters.rotational_acceleration));
 				}
 				else{
 					motor_parameters.rotational_acceleration = atoi(str_value_motor_value);
-					printf("User entered the new rotational acceleration = %0.1f steps/sec/sec\n\n",motor_parameters.rotational_acceleration);
+					DLOG(LOG_NEW_ACCEL, DLOG_TENTHS(motor_parameters.rotational_acceleration));
 				}
 			}
 			// update the value with the one given by the user, or keep it as the default
 			else if(parameters_flag == 3){
 				if(keep_default_value_flag == 1){
-					printf("User chooses to keep the default value of rotational deceleration = %0.1f steps/sec/sec\n\n",motor_parameters.rotational_deceleration);
+					DLOG(LOG_KEEP_DECEL, DLOG_TENTHS(motor_parameters.rotational_deceleration));
 				}
 				else{
 					motor_parameters.rotational_deceleration = atoi(str_value_motor_value);
-					printf("User entered the new rotational deceleration = %0.1f steps/sec/sec\n\n",motor_parameters.rotational_deceleration);
+					DLOG(LOG_NEW_DECEL, DLOG_TENTHS(motor_parameters.rotational_deceleration));
 				}
 			}
 			// update the value with the one given by the user, or keep it as the default
 			else if(parameters_flag == 4){
 				if(keep_default_value_flag == 1){
-					xil_printf("User chooses to keep the default value of destination position = %d\n\n", positionSequence[sequenceIndex][0]);
+					DLOG(LOG_KEEP_DESTINATION, positionSequence[sequenceIndex][0]);
 				}
 				else{
 					positionSequence[sequenceIndex][0] = atoi(str_value_motor_value);
-					xil_printf("User entered the new destination position = %d steps\n\n",positionSequence[sequenceIndex][0]);
+					DLOG(LOG_NEW_DESTINATION, positionSequence[sequenceIndex][0]);
 				}
 			}
 			// update the value with the one given by the user, or keep it as the default
 			else if(parameters_flag == 5){
 				if(keep_default_value_flag == 1){
-					xil_printf("User chooses to keep the default value of dwell time = %d\n", positionSequence[sequenceIndex][1]);
+					DLOG(LOG_KEEP_DWELL, positionSequence[sequenceIndex][1]);
 				}
 				else{
 					positionSequence[sequenceIndex][1] = atoi(str_value_motor_value);
-					xil_printf("User entered new dwell time = %d ms\n",positionSequence[sequenceIndex][1]);
+					DLOG(LOG_NEW_DWELL, positionSequence[sequenceIndex][1]);
 				}
 
-				xil_printf("*** Pair: %d\t, <destination, delay> = <%d, %d>\n\n", sequenceIndex+1, positionSequence[sequenceIndex][0], positionSequence[sequenceIndex][1]);
+				DLOG(LOG_PAIR, sequenceIndex+1, positionSequence[sequenceIndex][0], positionSequence[sequenceIndex][1]);
 
 				sequenceIndex ++;
 			}
@@ -360,10 +385,10 @@ static void _Task_Uart( void *pvParameters ){
 			else if(parameters_flag == 6){
 				// show the user the next menu
 				if(keep_default_value_flag == 1 || sequenceIndex == SEQUENCE_LENGTH){
-					xil_printf("User chooses to stop inputting sequences, or sequence full.\n\n");
-					xil_printf("\n****************************** MENU ******************************\n");
-					xil_printf("1. Press m<ENTER> to change the motor parameters again.\n");
-					xil_printf("2. Press g<ENTER> to start the movement of the motor.\n");
+					DLOG(LOG_MENU_STOP);
+					DLOG(LOG_MENU_HEADER);
+					DLOG(LOG_MENU_OPTIONS);
+					DLOG(LOG_MENU_UART_OPTIONS);
 
 					char command_1_or_2_values[100];
 					int index=0;
@@ -384,12 +409,28 @@ static void _Task_Uart( void *pvParameters ){
 									if((command == 'm') | (command == 'L') | (command == 'g')){
 										break;
 									}
-									else{
-										index = 0;
+									// the UART commands are handled here, the menu stays up
+									else if(command == 'b'){
+										UART_Baud_Index = (UART_Baud_Index + 1) % (sizeof(UART_Baud_Rates) / sizeof(UART_Baud_Rates[0]));
+										// not in the middle of a log message, and the new rate is printed before the log task goes on
+										xSemaphoreTake(UART_Tx_Mutex, portMAX_DELAY);
+										int baud_status = Set_UART_Baud(UART_Baud_Rates[UART_Baud_Index]);
+										xSemaphoreGive(UART_Tx_Mutex);
+										if(baud_status != XST_SUCCESS){
+											DLOG(LOG_BAUD_FAILED, UART_Baud_Rates[UART_Baud_Index]);
+										}
+									}
+									else if(command == 'e'){
+										Report_UART_Errors(1);
 									}
+									index = 0;
 								}
 							}
 						}
+						else{
+							Report_UART_Errors(0);
+							vTaskDelay(1);
+						}
 					}
 					// if the user enters 'm' go back to setting the motor parameters
 					if(command == 'm'){
@@ -406,7 +447,7 @@ static void _Task_Uart( void *pvParameters ){
 				// else the user wishes to input another position in the sequence
 				else{
 					positionSequence[sequenceIndex][0] = atoi(str_value_motor_value);
-					xil_printf("User entered the new destination position = %d steps\n\n",positionSequence[sequenceIndex][0]);
+					DLOG(LOG_NEW_DESTINATION, positionSequence[sequenceIndex][0]);
 					parameters_flag = 4;
 				}
 			}
@@ -438,7 +479,7 @@ static void _Task_Motor( void *pvParameters ){
 
 		/**********************************************************************************************/
 
-		xil_printf("\nStarting the Motor Rotation...\n");
+		DLOG(LOG_MOTOR_START);
 
 		// set the motor parameters by calling the respective stepper functions from the driver files.
 		// you need to set the ROTATIONAL SPEED, ROTATIONAL ACCELERATION, ROTATIONAL DECELERATION and CURRENT POSITION IN STEPS
@@ -463,8 +504,8 @@ static void _Task_Motor( void *pvParameters ){
 		/**********************************************************************************************/
 
 		// print the motor position, and reset variables to start getting the next position-delay sequence
-		xil_printf("\n\nCurrent position of the motor = %d steps\n", motor_parameters.currentposition_in_steps);
-		xil_printf("Press <ENTER> to keep this value, or type a new starting position and then <ENTER>\n");
+		DLOG(LOG_MOTOR_DONE, motor_parameters.currentposition_in_steps);
+		DLOG(LOG_POSITION_PROMPT);
 
 		parameters_flag = 0;
 		sequenceIndex = 0;
@@ -519,3 +560,25 @@ static void _Task_Emerg_Stop( void *pvParameters ){
 		vTaskDelay(pdMS_TO_TICKS(10));
 	}
 }
+
+
+//Logs the error counts when they have changed since the last report, or always with force
+static void Report_UART_Errors(int force){
+	const UartErrorCounts *errors = Poll_UART_Errors();
+	u32 total = errors->overrun + errors->framing + errors->parity;
+
+	if(force || total != UART_Errors_Seen){
+		UART_Errors_Seen = total;
+		DLOG(LOG_UART_ERRORS, errors->overrun, errors->framing, errors->parity);
+	}
+}
+
+
+//Runs in the log task, so the wait on the TX FIFO only holds up idle time
+static void Log_Sink(const char *buf, size_t len){
+	xSemaphoreTake(UART_Tx_Mutex, portMAX_DELAY);
+	while(len-- > 0){
+		outbyte(*buf++);
+	}
+	xSemaphoreGive(UART_Tx_Mutex);
+}
@@ -7,10 +7,23 @@
 
 
 #include "xuartps.h" 										//UART definitions header file
+#include "xil_printf.h"
+#include "uart_config.h"									//Baud selection and error counters
 #define UART_BASEADDR 		XPAR_UART1_BASEADDR 		//UART Device ID
+#define UART_BAUD_RATE 		115200 						//Start up rate, Set_UART_Baud() changes it
 
 XUartPs UART; 				//UART Instance
 XUartPs_Config *Config; 	//Pointer to UART
+UartBaudInfo UART_Baud; 	//Divisors and error of the current rate
+UartErrorCounts UART_Errors; //Overrun, framing and parity errors seen so far
+
+
+static void Print_UART_Baud(){
+	char line[96];
+
+	UART_formatBaud(line, sizeof(line), &UART_Baud);
+	xil_printf("%s", line);
+}
 
 
 int Initialize_UART(){
@@ -32,6 +45,43 @@ int Initialize_UART(){
 	xil_printf("UART PS init failed\n");
 	}
 
+	Status = UART_setBaud(&UART, UART_BAUD_RATE, &UART_Baud);
+	if (Status != XST_SUCCESS)
+	{
+	return XST_FAILURE;
+	}
+
+	Print_UART_Baud();
 	return XST_SUCCESS;
 }
 
+
+//Waits for the transmitter to drain at the old rate, up to 921600 baud. Prints the new rate with
+//xil_printf, so once the scheduler runs the caller holds the mutex the log sink writes under
+int Set_UART_Baud(u32 baud){
+
+	UartBaudInfo info;
+
+	if (UART_calcBaud(Config->InputClockHz, baud, &info) != XST_SUCCESS)
+	{
+	return XST_FAILURE;
+	}
+
+	while (!(XUartPs_ReadReg(UART_BASEADDR, XUARTPS_SR_OFFSET) & XUARTPS_SR_TXEMPTY));
+
+	if (UART_setBaud(&UART, baud, &UART_Baud) != XST_SUCCESS)
+	{
+	return XST_FAILURE;
+	}
+
+	Print_UART_Baud();
+	return XST_SUCCESS;
+}
+
+
+//The error bits latch, so polling now and then catches them
+const UartErrorCounts *Poll_UART_Errors(){
+	UART_pollErrors(UART_BASEADDR, &UART_Errors);
+	return &UART_Errors;
+}
+